@@ -0,0 +1,651 @@
+/*
+性能测试程序: 对一组测试文档测量解析, 生成和往返(解析+生成)的吞吐量, 单次解析的延迟分位数, 以及每个文档的内存分配次数
+测试文档(语料)由固定种子的伪随机数生成, 每次运行都完全相同, 不依赖网络或外部文件:
+    leptjson_bench              测试生成的语料
+    leptjson_bench -o <目录>    把生成的语料写成json文件
+    leptjson_bench <文件>...    测试指定的json文件
+*/
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//统计leptjson中每一次动态内存的分配: 直接包含leptjson.c, 并替换它的分配函数
+static size_t alloc_count;
+
+static void* bench_malloc(size_t size){
+    alloc_count++;
+    return malloc(size);
+}
+
+static void* bench_realloc(void* ptr, size_t size){
+    alloc_count++;
+    return realloc(ptr, size);
+}
+
+#define LEPT_MALLOC(size) bench_malloc(size)
+#define LEPT_REALLOC(ptr, size) bench_realloc(ptr, size)
+#include "leptjson.c"
+
+//每一项测试至少运行这么长时间, 并且至少运行BENCH_MIN_ITERATIONS次
+#ifndef BENCH_MIN_SECONDS
+#define BENCH_MIN_SECONDS 0.5
+#endif
+#ifndef BENCH_MIN_ITERATIONS
+#define BENCH_MIN_ITERATIONS 10
+#endif
+//最多记录这么多次的单次耗时, 用于计算分位数
+#define BENCH_MAX_SAMPLES 10000
+
+/*计时部分*/
+#ifdef _WIN32
+static double now(){
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / (double)f.QuadPart;
+}
+#else
+static double now(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+#endif
+
+/*语料生成部分*/
+//可增长的输出缓冲区
+typedef struct{
+    char* s;
+    size_t len, cap;
+}buffer;
+
+static void put(buffer* b, const char* s, size_t len){
+    if(b->len + len + 1 > b->cap){
+        while(b->len + len + 1 > b->cap)
+            b->cap = b->cap ? b->cap * 2 : 4096;
+        b->s = (char*)realloc(b->s, b->cap);
+        if(!b->s){
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(b->s + b->len, s, len);
+    b->len += len;
+    b->s[b->len] = '\0';
+}
+
+static void put_str(buffer* b, const char* s){
+    put(b, s, strlen(s));
+}
+
+static void put_format(buffer* b, const char* format, ...){
+    char tmp[512];
+    int n;
+    va_list ap;
+    va_start(ap, format);
+    n = vsprintf(tmp, format, ap);
+    va_end(ap);
+    put(b, tmp, (size_t)n);
+}
+
+//固定种子的伪随机数(xorshift32), 保证每次生成的语料相同
+static unsigned seed;
+
+static unsigned rnd(unsigned n){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed % n;
+}
+
+static const char* words[] = {
+    "json", "parser", "fast", "tweet", "hello", "world", "leptjson", "stream", "data", "value",
+    "\xe6\x9d\xb1\xe4\xba\xac", "\xe3\x81\x82\xe3\x82\x8a\xe3\x81\x8c\xe3\x81\xa8\xe3\x81\x86", "caf\xc3\xa9",
+    "\\u3042\\u3044", "\\\"quoted\\\"", "line\\nbreak", "http:\\/\\/t.co\\/x", "\\ud83d\\ude00"
+};
+
+//由随机单词组成的字符串内容, 包含UTF-8字符和各种转义
+static void put_text(buffer* b, unsigned count){
+    unsigned i;
+    for(i = 0; i < count; i++){
+        if(i) put(b, " ", 1);
+        put_str(b, words[rnd(sizeof(words) / sizeof(words[0]))]);
+    }
+}
+
+//类似twitter.json: 对象为主, 包含大量短字符串, 非ASCII文本, 整数, 布尔值和null
+static void make_twitter(buffer* b){
+    unsigned i, j;
+    put_str(b, "{\"statuses\":[");
+    for(i = 0; i < 1000; i++){
+        unsigned long long id = 505874924095815681ULL + rnd(1000000);
+        if(i) put(b, ",", 1);
+        put_format(b, "{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"%s\"},", rnd(2) ? "ja" : "en");
+        put_format(b, "\"created_at\":\"Sun Aug 31 00:%02u:%02u +0000 2014\",\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"", rnd(60), rnd(60), id, id);
+        put_text(b, 5 + rnd(15));
+        put_str(b, "\",\"source\":\"<a href=\\\"http:\\/\\/twitter.com\\/download\\/iphone\\\" rel=\\\"nofollow\\\">Twitter for iPhone<\\/a>\",");
+        put_str(b, "\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":null,\"in_reply_to_screen_name\":null,");
+        put_format(b, "\"user\":{\"id\":%u,\"id_str\":\"%u\",\"name\":\"", 1186275104 + rnd(100000), 1186275104 + rnd(100000));
+        put_text(b, 1 + rnd(2));
+        put_format(b, "\",\"screen_name\":\"user_%u\",\"location\":\"", rnd(100000));
+        put_text(b, rnd(3));
+        put_str(b, "\",\"description\":\"");
+        put_text(b, rnd(20));
+        put_format(b, "\",\"url\":null,\"protected\":false,\"followers_count\":%u,\"friends_count\":%u,\"listed_count\":%u,",
+            rnd(100000), rnd(5000), rnd(100));
+        put_format(b, "\"favourites_count\":%u,\"utc_offset\":null,\"time_zone\":null,\"geo_enabled\":%s,\"verified\":%s,\"statuses_count\":%u,",
+            rnd(10000), rnd(2) ? "true" : "false", rnd(10) ? "false" : "true", rnd(100000));
+        put_format(b, "\"profile_image_url\":\"http:\\/\\/pbs.twimg.com\\/profile_images\\/%u\\/normal.jpeg\",\"default_profile\":%s},",
+            rnd(1000000000), rnd(2) ? "true" : "false");
+        put_format(b, "\"geo\":null,\"coordinates\":null,\"place\":null,\"retweet_count\":%u,\"favorite_count\":%u,\"entities\":{\"hashtags\":[",
+            rnd(1000), rnd(1000));
+        for(j = rnd(4); j > 0; j--){
+            put_str(b, "{\"text\":\"");
+            put_text(b, 1);
+            put_format(b, "\",\"indices\":[%u,%u]}%s", rnd(100), 100 + rnd(40), j > 1 ? "," : "");
+        }
+        put_str(b, "],\"symbols\":[],\"urls\":[],\"user_mentions\":[");
+        for(j = rnd(3); j > 0; j--)
+            put_format(b, "{\"screen_name\":\"user_%u\",\"name\":\"n%u\",\"id\":%u,\"indices\":[%u,%u]}%s",
+                rnd(100000), rnd(1000), rnd(2000000000), rnd(10), 10 + rnd(10), j > 1 ? "," : "");
+        put_format(b, "]},\"favorited\":false,\"retweeted\":false,\"lang\":\"%s\"}", rnd(2) ? "ja" : "en");
+    }
+    put_str(b, "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"count\":1000}}");
+}
+
+//类似canada.json: GeoJSON多边形, 几乎全部是17位有效数字的浮点数坐标
+static void make_canada(buffer* b){
+    unsigned ring, i;
+    put_str(b, "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},"
+               "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[");
+    for(ring = 0; ring < 480; ring++){
+        double lon = -141.0 + rnd(8000) / 100.0, lat = 42.0 + rnd(4000) / 100.0;
+        unsigned points = 20 + rnd(200);
+        if(ring) put(b, ",", 1);
+        put(b, "[", 1);
+        for(i = 0; i < points; i++){
+            lon += (rnd(2000001) / 1000000.0 - 1.0) * 0.01;
+            lat += (rnd(2000001) / 1000000.0 - 1.0) * 0.01;
+            put_format(b, "%s[%.17g,%.17g]", i ? "," : "", lon, lat);
+        }
+        put(b, "]", 1);
+    }
+    put_str(b, "]}}]}");
+}
+
+//类似citm_catalog.json: 大量以数字字符串为键的对象, 嵌套的小对象和整数数组
+static void make_citm(buffer* b){
+    unsigned i, j;
+    put_str(b, "{\"areaNames\":{");
+    for(i = 0; i < 200; i++){
+        put_format(b, "%s\"%u\":\"", i ? "," : "", 205705993 + i);
+        put_text(b, 2);
+        put(b, "\"", 1);
+    }
+    put_str(b, "},\"events\":{");
+    for(i = 0; i < 1000; i++){
+        unsigned id = 138586341 + i * 4;
+        put_format(b, "%s\"%u\":{\"description\":null,\"id\":%u,\"logo\":%s,\"name\":\"", i ? "," : "", id, id,
+            rnd(3) ? "null" : "\"/images/UE0AAAAACEKo6QAAAAZDSVRN\"");
+        put_text(b, 2 + rnd(3));
+        put_str(b, "\",\"subTopicIds\":[");
+        for(j = 1 + rnd(4); j > 0; j--)
+            put_format(b, "%u%s", 337184262 + rnd(100), j > 1 ? "," : "");
+        put_str(b, "],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[");
+        for(j = 1 + rnd(3); j > 0; j--)
+            put_format(b, "%u%s", 107888604 + rnd(1000), j > 1 ? "," : "");
+        put_str(b, "]}");
+    }
+    put_str(b, "},\"performances\":[");
+    for(i = 0; i < 2000; i++){
+        put_format(b, "%s{\"eventId\":%u,\"id\":%u,\"logo\":null,\"name\":null,\"prices\":[", i ? "," : "", 138586341 + rnd(1000) * 4, 339887544 + i);
+        for(j = 1 + rnd(5); j > 0; j--)
+            put_format(b, "{\"amount\":%u,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":%u}%s",
+                10000 + rnd(100) * 250, 338937295 + rnd(10), j > 1 ? "," : "");
+        put_str(b, "],\"seatCategories\":[");
+        for(j = 1 + rnd(4); j > 0; j--)
+            put_format(b, "{\"areas\":[{\"areaId\":%u,\"blockIds\":[]},{\"areaId\":%u,\"blockIds\":[]}],\"seatCategoryId\":%u}%s",
+                205705993 + rnd(200), 205705993 + rnd(200), 338937295 + rnd(10), j > 1 ? "," : "");
+        put_format(b, "],\"seatMapImage\":null,\"start\":%llu,\"venueCode\":\"PLEYEL_PLEYEL\"}", 1372701600000ULL + rnd(100000) * 1000ULL);
+    }
+    put_str(b, "],\"venueNames\":{\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}");
+}
+
+//深层嵌套: 每个元素是交替嵌套的对象和数组, 嵌套深度为200
+static void make_nested(buffer* b){
+    unsigned i, d;
+    put(b, "[", 1);
+    for(i = 0; i < 500; i++){
+        if(i) put(b, ",", 1);
+        for(d = 0; d < 100; d++)
+            put_format(b, "{\"k%u\":[%u,", d, rnd(100));
+        put_str(b, "null");
+        for(d = 0; d < 100; d++)
+            put_str(b, "]}");
+    }
+    put(b, "]", 1);
+}
+
+//长字符串: 每个字符串约4KB, 大部分是无需转义的ASCII, 间或出现转义字符和UTF-8字符
+static void make_long_strings(buffer* b){
+    unsigned i, j;
+    put(b, "[", 1);
+    for(i = 0; i < 500; i++){
+        if(i) put(b, ",", 1);
+        put(b, "\"", 1);
+        for(j = 0; j < 4096; j++){
+            unsigned r = rnd(1000);
+            if(r == 0) put_str(b, "\\n");
+            else if(r == 1) put_str(b, "\\\"");
+            else if(r == 2) put_str(b, "\\u00e9");
+            else if(r == 3) put_str(b, "\xe2\x82\xac");
+            else put(b, &"abcdefghijklmnopqrstuvwxyz ,.0123456789"[r % 39], 1);
+        }
+        put(b, "\"", 1);
+    }
+    put(b, "]", 1);
+}
+
+//小文档: 一条几百字节的记录, 单次解析的固定开销(堆栈的申请和增长)占比最大
+static void make_small(buffer* b){
+    put_format(b, "{\"id\":%u,\"name\":\"", rnd(1000000));
+    put_text(b, 2);
+    put_format(b, "\",\"score\":%u.%02u,\"active\":%s,\"tags\":[\"a%u\",\"b%u\",\"c%u\"],",
+        rnd(100), rnd(100), rnd(2) ? "true" : "false", rnd(100), rnd(100), rnd(100));
+    put_format(b, "\"owner\":{\"id\":%u,\"email\":\"user_%u@example.com\"},\"comment\":\"", rnd(100000), rnd(100000));
+    put_text(b, 8);
+    put_str(b, "\",\"parent\":null}");
+}
+
+typedef struct{
+    const char* name;
+    void (*make)(buffer* b);
+}generator;
+
+static const generator corpus[] = {
+    { "twitter", make_twitter },
+    { "canada", make_canada },
+    { "citm_catalog", make_citm },
+    { "nested", make_nested },
+    { "long_strings", make_long_strings },
+    { "small", make_small }
+};
+
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+static buffer generate(const generator* g){
+    buffer b = { NULL, 0, 0 };
+    seed = 2463534242u;
+    g->make(&b);
+    return b;
+}
+
+/*测试部分*/
+typedef struct{
+    double mbps;          //吞吐量
+    double p50, p90, p99; //单次耗时的分位数(微秒)
+}result;
+
+static int compare_double(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+//重复执行fn, 直到运行时间和次数都达到下限; bytes为每次处理的字节数
+static result measure(void (*fn)(void* ctx), void* ctx, size_t bytes){
+    static double samples[BENCH_MAX_SAMPLES];
+    result r;
+    size_t n = 0, i = 0;
+    double start = now(), total;
+    do {
+        double t = now();
+        fn(ctx);
+        t = now() - t;
+        if(n < BENCH_MAX_SAMPLES)
+            samples[n++] = t;
+        i++;
+    } while(i < BENCH_MIN_ITERATIONS || now() - start < BENCH_MIN_SECONDS);
+    total = now() - start;
+    qsort(samples, n, sizeof(double), compare_double);
+    r.mbps = (double)bytes * i / total / (1024.0 * 1024.0);
+    r.p50 = samples[n * 50 / 100] * 1e6;
+    r.p90 = samples[n * 90 / 100] * 1e6;
+    r.p99 = samples[n * 99 / 100] * 1e6;
+    return r;
+}
+
+typedef struct{
+    const char* json;
+    size_t len;
+    lept_value v;       //解析好的节点, 用于测试生成
+    lept_arena arena;
+    lept_parser parser; //在多次解析之间复用的解析器
+    lept_parser interned; //使用键值驻留池的解析器
+    size_t out_len;     //生成的文本长度
+}document;
+
+static void fail(const char* what){
+    fprintf(stderr, "%s failed\n", what);
+    exit(1);
+}
+
+static void run_parse(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parse_n(&v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("parse");
+    lept_free(&v);
+}
+
+static void run_stringify(void* ctx){
+    document* d = (document*)ctx;
+    free(lept_stringify(&d->v, &d->out_len));
+}
+
+static void run_roundtrip(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parse_n(&v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("parse");
+    free(lept_stringify(&v, NULL));
+    lept_free(&v);
+}
+
+static void run_arena(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    lept_arena_reset(&d->arena);
+    if(lept_parse_arena(&d->arena, &v, d->json) != LEPT_PARSE_OK)
+        fail("arena parse");
+}
+
+static int count_value(void* ctx){
+    ++*(size_t*)ctx;
+    return 1;
+}
+
+static int count_number(void* ctx, double n){
+    (void)n;
+    return count_value(ctx);
+}
+
+static int count_string(void* ctx, const char* s, size_t len){
+    (void)s;
+    (void)len;
+    return count_value(ctx);
+}
+
+static void run_sax(void* ctx){
+    document* d = (document*)ctx;
+    lept_handler h;
+    size_t count = 0;
+    memset(&h, 0, sizeof(h));
+    h.number = count_number;
+    h.string = count_string;
+    h.null_value = count_value;
+    if(lept_parse_sax(&h, &count, d->json, d->len) != LEPT_PARSE_OK)
+        fail("sax parse");
+}
+
+//以4KB为一段传入增量解析器
+static void run_chunks(void* ctx){
+    document* d = (document*)ctx;
+    lept_parser p;
+    lept_value v;
+    size_t off;
+    lept_parser_init(&p);
+    for(off = 0; off < d->len; off += 4096)
+        lept_parser_feed(&p, d->json + off, d->len - off < 4096 ? d->len - off : 4096);
+    if(lept_parser_finish(&p, &v) != LEPT_PARSE_OK)
+        fail("chunked parse");
+    lept_free(&v);
+    lept_parser_free(&p);
+}
+
+//复用同一个解析器的堆栈
+static void run_reused(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parser_parse_n(&d->parser, &v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("reused parse");
+    lept_free(&v);
+}
+
+//键值从驻留池中获取
+static void run_interned(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parser_parse_n(&d->interned, &v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("interned parse");
+    lept_free(&v);
+}
+
+static void run_view(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parse_view(&v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("view parse");
+    lept_free(&v);
+}
+
+//惰性解析只展开根节点一层, 相当于只读取少数几个字段
+static void run_lazy(void* ctx){
+    document* d = (document*)ctx;
+    lept_value v;
+    if(lept_parse_lazy(&v, d->json, d->len) != LEPT_PARSE_OK)
+        fail("lazy parse");
+    lept_free(&v);
+}
+
+static void run_tape(void* ctx){
+    document* d = (document*)ctx;
+    lept_tape t;
+    if(lept_parse_tape(&t, d->json, d->len) != LEPT_PARSE_OK)
+        fail("tape parse");
+    lept_tape_free(&t);
+}
+
+static int discard(void* ctx, const char* data, size_t len){
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return 1;
+}
+
+static void run_stringify_to(void* ctx){
+    document* d = (document*)ctx;
+    lept_stringify_to(&d->v, discard, NULL);
+}
+
+//统计执行一次fn的分配次数
+static size_t count_allocs(void (*fn)(void* ctx), void* ctx){
+    size_t before = alloc_count;
+    fn(ctx);
+    return alloc_count - before;
+}
+
+static void bench(const char* name, const char* json, size_t len){
+    document d;
+    result parse, stringify, roundtrip, arena, sax, chunks, writer, tape, view, lazy, reused, interned;
+    size_t parse_allocs, stringify_allocs, view_allocs, reused_allocs, interned_allocs;
+    lept_intern* pool = lept_intern_create(0);
+    d.json = json;
+    d.len = len;
+    //lept_parse_arena要求文本以'\0'结尾且中间没有'\0'
+    if(strlen(json) != len || lept_parse_n(&d.v, json, len) != LEPT_PARSE_OK)
+        fail(name);
+    lept_arena_init(&d.arena, 0);
+    lept_parser_init(&d.parser);
+    lept_parser_init(&d.interned);
+    lept_parser_set_intern(&d.interned, pool);
+
+    parse_allocs = count_allocs(run_parse, &d);
+    stringify_allocs = count_allocs(run_stringify, &d);
+    view_allocs = count_allocs(run_view, &d);
+    run_reused(&d);
+    reused_allocs = count_allocs(run_reused, &d);
+    run_interned(&d);
+    interned_allocs = count_allocs(run_interned, &d);
+    parse = measure(run_parse, &d, len);
+    stringify = measure(run_stringify, &d, d.out_len);
+    roundtrip = measure(run_roundtrip, &d, len);
+    arena = measure(run_arena, &d, len);
+    sax = measure(run_sax, &d, len);
+    chunks = measure(run_chunks, &d, len);
+    writer = measure(run_stringify_to, &d, d.out_len);
+    tape = measure(run_tape, &d, len);
+    view = measure(run_view, &d, len);
+    lazy = measure(run_lazy, &d, len);
+    reused = measure(run_reused, &d, len);
+    interned = measure(run_interned, &d, len);
+
+    printf("%-14s %8.0f %9.1f %9.1f %9.1f  %8.0f %8.0f %8.0f  %8lu %5lu\n",
+        name, len / 1024.0, parse.mbps, stringify.mbps, roundtrip.mbps,
+        parse.p50, parse.p90, parse.p99, (unsigned long)parse_allocs, (unsigned long)stringify_allocs);
+    printf("%-14s %8s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f  %8lu %9.1f %9.1f  %8lu %9.1f  %8lu\n", "", "", arena.mbps, sax.mbps, chunks.mbps, writer.mbps, tape.mbps,
+        view.mbps, (unsigned long)view_allocs, lazy.mbps, reused.mbps, (unsigned long)reused_allocs, interned.mbps, (unsigned long)interned_allocs);
+    lept_free(&d.v);
+    lept_arena_free(&d.arena);
+    lept_parser_free(&d.parser);
+    lept_parser_free(&d.interned);
+    lept_intern_free(pool);
+}
+
+//多线程: 把twitter的每条status生成为一行(NDJSON), 或者作为一个大数组的元素, 比较单线程与使用所有处理器的解析吞吐量
+typedef struct{
+    const char* json;
+    size_t len, threads;
+}parallel;
+
+static void run_ndjson(void* ctx){
+    parallel* d = (parallel*)ctx;
+    lept_value v;
+    if(lept_parse_ndjson(&v, d->json, d->len, d->threads) != LEPT_PARSE_OK)
+        fail("ndjson parse");
+    lept_free(&v);
+}
+
+static void run_parallel(void* ctx){
+    parallel* d = (parallel*)ctx;
+    lept_value v;
+    if(lept_parse_parallel(&v, d->json, d->len, d->threads) != LEPT_PARSE_OK)
+        fail("parallel parse");
+    lept_free(&v);
+}
+
+static void bench_parallel(){
+    buffer b = generate(&corpus[0]), lines = { NULL, 0, 0 }, array = { NULL, 0, 0 };
+    lept_value v;
+    const lept_value* statuses;
+    parallel d;
+    result one, all;
+    size_t i, round, count;
+    if(lept_parse_n(&v, b.s, b.len) != LEPT_PARSE_OK)
+        fail("parallel");
+    statuses = lept_find_object_value(&v, "statuses", 8);
+    put(&array, "[", 1);
+    for(round = 0, count = 0; round < 8; round++){
+        for(i = 0; i < lept_get_array_size(statuses); i++, count++){
+            size_t len;
+            char* s = lept_stringify(lept_get_array_element(statuses, i), &len);
+            put(&lines, s, len);
+            put(&lines, "\n", 1);
+            if(count) put(&array, ",", 1);
+            put(&array, s, len);
+            free(s);
+        }
+    }
+    put(&array, "]", 1);
+    printf("\n%lu records, %.0f KB, %lu processors\n", (unsigned long)count, lines.len / 1024.0, (unsigned long)lept_processor_count());
+    d.json = lines.s;
+    d.len = lines.len;
+    d.threads = 1;
+    one = measure(run_ndjson, &d, d.len);
+    d.threads = 0;
+    all = measure(run_ndjson, &d, d.len);
+    printf("ndjson         1 thread %9.1f MB/s, all processors %9.1f MB/s\n", one.mbps, all.mbps);
+    d.json = array.s;
+    d.len = array.len;
+    d.threads = 1;
+    one = measure(run_parallel, &d, d.len);
+    d.threads = 0;
+    all = measure(run_parallel, &d, d.len);
+    printf("array          1 thread %9.1f MB/s, all processors %9.1f MB/s\n", one.mbps, all.mbps);
+    lept_free(&v);
+    free(lines.s);
+    free(array.s);
+    free(b.s);
+}
+
+static void header(){
+    printf("throughput in MB/s; latency of one DOM parse in microseconds; mallocs per parse, per stringify, per view parse, per reused parse and per interned parse\n");
+    printf("%-14s %8s %9s %9s %9s  %8s %8s %8s  %8s %5s\n",
+        "document", "KB", "parse", "stringify", "roundtrip", "p50", "p90", "p99", "mallocs", "out");
+    printf("%-14s %8s %9s %9s %9s %9s %9s %9s  %8s %9s %9s  %8s %9s  %8s\n", "", "", "arena", "sax", "4KB chunk", "writer", "tape", "view", "mallocs", "lazy", "reused", "mallocs", "interned", "mallocs");
+}
+
+static char* read_file(const char* path, size_t* len){
+    FILE* fp = fopen(path, "rb");
+    char* json;
+    long size;
+    if(!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    json = size < 0 ? NULL : (char*)malloc((size_t)size + 1);
+    if(json && fread(json, 1, (size_t)size, fp) != (size_t)size){
+        free(json);
+        json = NULL;
+    }
+    fclose(fp);
+    if(json){
+        json[size] = '\0';
+        *len = (size_t)size;
+    }
+    return json;
+}
+
+int main(int argc, char* argv[]){
+    size_t i;
+    if(argc == 3 && strcmp(argv[1], "-o") == 0){
+        for(i = 0; i < CORPUS_SIZE; i++){
+            buffer b = generate(&corpus[i]);
+            char path[1100];
+            FILE* fp;
+            sprintf(path, "%.1000s/%s.json", argv[2], corpus[i].name);
+            fp = fopen(path, "wb");
+            if(!fp || fwrite(b.s, 1, b.len, fp) != b.len)
+                fail(path);
+            fclose(fp);
+            printf("%s (%lu bytes)\n", path, (unsigned long)b.len);
+            free(b.s);
+        }
+        return 0;
+    }
+    header();
+    if(argc > 1){
+        for(i = 1; i < (size_t)argc; i++){
+            size_t len = 0;
+            char* json = read_file(argv[i], &len);
+            if(!json)
+                fail(argv[i]);
+            bench(argv[i], json, len);
+            free(json);
+        }
+    }
+    else{
+        for(i = 0; i < CORPUS_SIZE; i++){
+            buffer b = generate(&corpus[i]);
+            bench(corpus[i].name, b.s, b.len);
+            free(b.s);
+        }
+        bench_parallel();
+    }
+    return 0;
+}
@@ -1,3 +1,8 @@
+//使用-std=c99编译时, 需要声明POSIX才能使用mmap等文件映射的接口和pthread
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #ifdef _WINDOWS
 #define _CRTDBG_MAP_ALLOC
 #include <crtdbg.h>
@@ -7,9 +12,37 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <errno.h> /* errno, ERANGE */
+#include <float.h> /* FLT_EVAL_METHOD */
 #include <math.h> /* HUGE_VAL */
+#include <stdint.h> /* uint64_t */
 #include <string.h> /* memcpy */
+#include "leptjson_pow5.h"
+
+#ifdef _WIN32
+#include <windows.h> /* CreateFileMapping, MapViewOfFile */
+#else
+#include <fcntl.h>    /* open */
+#include <sys/mman.h> /* mmap */
+#include <sys/stat.h> /* fstat */
+#include <unistd.h>   /* close, sysconf */
+#ifndef LEPT_NO_THREADS
+#include <pthread.h>
+#endif
+#endif
+
+//字符串扫描的向量化实现, 根据编译器开启的指令集选择: AVX2 > SSE2 > SWAR(按机器字并行比较)
+//定义LEPT_NO_SIMD可以强制使用可移植的SWAR实现
+#if defined(LEPT_NO_SIMD)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define LEPT_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEPT_SCAN_SSE2
+#endif
+#if defined(_MSC_VER) && (defined(LEPT_SCAN_AVX2) || defined(LEPT_SCAN_SSE2))
+#include <intrin.h> /* _BitScanForward */
+#endif
 
 //与当前c->json指向的字符进行断言比较, 如果通过, 那么c->json指针加一
 #define EXPECT(c,ch) do{ assert((*(c->json)) == (ch)); c->json++; }while(0)
@@ -20,6 +53,21 @@
 
 #define PUTS(c, s, len)     memcpy(lept_content_push(c, len), s, len)
 
+//读取当前字符, 到达json文本结尾时得到'\0'
+#define PEEK(c) ((c)->json < (c)->end ? *(c)->json : '\0')
+
+//动态内存的分配函数, 可以在编译时替换(例如统计分配次数);
+//替换之后, lept_stringify返回的字符串也要用LEPT_FREE对应的函数释放
+#ifndef LEPT_MALLOC
+#define LEPT_MALLOC(size) malloc(size)
+#endif
+#ifndef LEPT_REALLOC
+#define LEPT_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+#ifndef LEPT_FREE
+#define LEPT_FREE(ptr) free(ptr)
+#endif
+
 //定义了动态内存空间中的大小为256字节;
 #ifndef LEPT_PARSE_STACK_INIT_SIZE
 #define LEPT_PARSE_STACK_INIT_SIZE 256
@@ -29,15 +77,51 @@
 #define LEPT_PARSE_STRINGIFY_INIT_SIZE 256
 #endif
 
+//lept_stringify_to的输出缓冲区大小, 每写满一次调用一次writer
+#ifndef LEPT_STRINGIFY_BUFFER_SIZE
+#define LEPT_STRINGIFY_BUFFER_SIZE 4096
+#endif
+
+//arena中每个内存块的默认大小为64KB
+#ifndef LEPT_ARENA_CHUNK_SIZE
+#define LEPT_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+//arena中分配的空间按8字节对齐, 满足double和指针的对齐要求
+#define LEPT_ARENA_ALIGN 8
+
+//开启索引(lept_parser_set_index)时, 成员个数达到这个值的对象在解析时建立哈希索引
+#ifndef LEPT_OBJECT_INDEX_THRESHOLD
+#define LEPT_OBJECT_INDEX_THRESHOLD 16
+#endif
 
 
-static int lept_parse_value(lept_content* c, lept_value* v);//forward declare
+
+static void* lept_content_push(lept_content* c, size_t size);
+static void* lept_content_pop(lept_content* c, size_t size);
+static void lept_content_flush(lept_content* c);
+static void lept_content_write(lept_content* c, const char* s, size_t len);
+
+//用长度为len的json文本初始化c: 堆栈为空, 所有的模式字段都是关闭的, 需要的模式由调用者再打开
+static void lept_content_init(lept_content* c, const char* json, size_t len){
+    c->json = json;
+    c->end = json != NULL ? json + len : NULL;
+    c->stack = NULL;
+    c->size = 0;
+    c->top = 0;
+    c->arena = NULL;
+    c->out = NULL;
+    c->view = 0;
+    c->lazy = 0;
+    c->intern = NULL;
+    c->index = 0;
+}
 
 
 /* whitespace = *(%x20 / %x09 / %x0A / %x0D) */
 static void lept_parse_whiteSpace(lept_content* c){
     const char* p = c->json;
-    while(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'){
+    while(p < c->end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')){
         p++;
     }
     c->json = p;//移动到指向value值的位置
@@ -46,7 +130,7 @@ static void lept_parse_whiteSpace(lept_content* c){
 static int lept_parse_null(lept_content* c, lept_value* v){
     assert(*(c->json) == 'n'); //断言判读
     c->json++;
-    if(c->json[0] != 'u' || c->json[1] != 'l' || c->json[2] != 'l' )
+    if(c->end - c->json < 3 || c->json[0] != 'u' || c->json[1] != 'l' || c->json[2] != 'l' )
         return LEPT_PARSE_INVALID_VALUE;
     c->json += 3;
     v->type = LEPT_NULL;
@@ -56,7 +140,7 @@ static int lept_parse_false(lept_content* c, lept_value* v){
     assert(*(c->json) == 'f'); //断言判读
     c->json++;
 
-    if(c->json[0] != 'a' || c->json[1] != 'l' || c->json[2] != 's' || c->json[3] != 'e')
+    if(c->end - c->json < 4 || c->json[0] != 'a' || c->json[1] != 'l' || c->json[2] != 's' || c->json[3] != 'e')
         return LEPT_PARSE_INVALID_VALUE;
     c->json += 4;
     v->type = LEPT_FALSE;
@@ -66,49 +150,392 @@ static int lept_parse_true(lept_content* c, lept_value* v){
     assert(*(c->json) == 't'); //断言判读
     c->json++;
 
-    if(c->json[0] != 'r' || c->json[1] != 'u' || c->json[2] != 'e')
+    if(c->end - c->json < 3 || c->json[0] != 'r' || c->json[1] != 'u' || c->json[2] != 'e')
         return LEPT_PARSE_INVALID_VALUE;
     c->json += 3;
     v->type = LEPT_TRUE;
     return LEPT_PARSE_OK;
 }
 
-static double lept_parse_double(lept_content* c, lept_value* v){
+/*number转换部分*/
+//把十进制的 w * 10^q 转换为double, 采用 Clinger 快速路径 + Eisel-Lemire 算法,
+//只有有效数字超过19位且截断后无法确定舍入方向时, 才用大整数精确比较(lept_decimal_slow);
+//整个转换都不经过strtod, 结果与locale无关
+
+//64位乘以64位得到128位的结果
+typedef struct { uint64_t hi, lo; } lept_uint128;
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 lept_native_uint128;
+#endif
+
+static lept_uint128 lept_mul64(uint64_t a, uint64_t b){
+    lept_uint128 r;
+#if defined(__SIZEOF_INT128__)
+    lept_native_uint128 p = (lept_native_uint128)a * b;
+    r.hi = (uint64_t)(p >> 64);
+    r.lo = (uint64_t)p;
+#else
+    //拆分为32位的部分积
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    r.lo = (mid << 32) | (uint32_t)p0;
+    r.hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+    return r;
+}
+
+//w不为0, 返回最高位之前0的个数
+static int lept_leading_zeros(uint64_t w){
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(w);
+#else
+    int n = 0;
+    while (!(w & ((uint64_t)1 << 63))) { w <<= 1; n++; }
+    return n;
+#endif
+}
+
+//Eisel-Lemire算法, 对于不超过19位有效数字的w, 结果是正确舍入的;
+//返回double的二进制表示(不含符号位), 上溢时为无穷大的表示
+static uint64_t lept_eisel_lemire(uint64_t w, int q){
+    lept_uint128 product;
+    uint64_t mantissa;
+    int lz, upperbit, shift, power2;
+    const uint64_t* pow5;
+    if (w == 0 || q < LEPT_POW5_MIN_EXPONENT)
+        return 0;
+    if (q > LEPT_POW5_MAX_EXPONENT)
+        return (uint64_t)0x7FF << 52;
+
+    lz = lept_leading_zeros(w);
+    w <<= lz;
+    //w乘以5^q的近似值, 只有高位的低9位全为1时才需要用到表中的低64位来修正
+    pow5 = &lept_pow5_128[2 * (q - LEPT_POW5_MIN_EXPONENT)];
+    product = lept_mul64(w, pow5[0]);
+    if ((product.hi & 0x1FF) == 0x1FF) {
+        lept_uint128 second = lept_mul64(w, pow5[1]);
+        product.lo += second.hi;
+        if (second.hi > product.lo)
+            product.hi++;
+    }
+    upperbit = (int)(product.hi >> 63);
+    shift = upperbit + 64 - 52 - 3;
+    mantissa = product.hi >> shift;
+    //floor(log2(10^q)) = (217706 * q) >> 16
+    power2 = (int)((((int64_t)(152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+
+    if (power2 <= 0) {
+        //非规格化数
+        if (-power2 + 1 >= 64)
+            return 0;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        //舍入之后可能恰好进位成为最小的规格化数
+        power2 = mantissa < ((uint64_t)1 << 52) ? 0 : 1;
+        return ((uint64_t)power2 << 52) | (mantissa & (((uint64_t)1 << 52) - 1));
+    }
+    //恰好落在两个double中间时, 向偶数舍入
+    if (product.lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == product.hi)
+        mantissa &= ~(uint64_t)1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((uint64_t)2 << 52)) {
+        mantissa = (uint64_t)1 << 52;
+        power2++;
+    }
+    if (power2 >= 0x7FF)
+        return (uint64_t)0x7FF << 52;
+    return ((uint64_t)power2 << 52) | (mantissa & (((uint64_t)1 << 52) - 1));
+}
+
+//把校验过的十进制数转换为double, digits_truncated表示w是截断了19位之后的有效数字
+//无法确定结果时返回0, 由调用者退回到lept_decimal_slow
+static int lept_decimal_to_double(uint64_t w, int q, int negative, int digits_truncated, double* d){
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    uint64_t bits;
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    //Clinger快速路径: w和10^|q|都可以精确表示为double时, 一次乘除法的结果就是正确舍入的
+    if (!digits_truncated && q >= -22 && q <= 22 && w <= ((uint64_t)1 << 53)) {
+        *d = (double)w;
+        if (q < 0) *d /= pow10[-q];
+        else       *d *= pow10[q];
+        if (negative) *d = -*d;
+        return 1;
+    }
+#else
+    (void)pow10;
+#endif
+    bits = lept_eisel_lemire(w, q);
+    //截断的有效数字介于w和w+1之间, 两者结果相同才能确定
+    if (digits_truncated && bits != lept_eisel_lemire(w + 1, q))
+        return 0;
+    if (negative)
+        bits |= (uint64_t)1 << 63;
+    memcpy(d, &bits, sizeof(*d));
+    return 1;
+}
+
+/*精确比较部分*/
+//截断的有效数字无法确定舍入方向时, 结果只可能是bits或者它的下一个double,
+//用大整数精确比较十进制数和两者的中点来决定. 中点最多有767位有效数字,
+//因此只需要保留前768位有效数字, 之后的数字只记录是否非0
+#define LEPT_BIGNUM_DIGITS 768
+//比较时两边的大整数都不超过约2700位
+#define LEPT_BIGNUM_LIMBS 128
+
+typedef struct {
+    uint32_t limb[LEPT_BIGNUM_LIMBS]; //低位在前, 最高位的limb不为0
+    int n;
+} lept_bignum;
+
+//a = a * m + add
+static void lept_bignum_mul_add(lept_bignum* a, uint32_t m, uint32_t add){
+    uint64_t carry = add;
+    int i;
+    for (i = 0; i < a->n; i++) {
+        carry += (uint64_t)a->limb[i] * m;
+        a->limb[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        assert(a->n < LEPT_BIGNUM_LIMBS);
+        a->limb[a->n++] = (uint32_t)carry;
+    }
+}
+
+//a = a * 5^e
+static void lept_bignum_pow5(lept_bignum* a, int e){
+    static const uint32_t pow5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625,
+        1953125, 9765625, 48828125, 244140625, 1220703125 };
+    for (; e >= 13; e -= 13)
+        lept_bignum_mul_add(a, pow5[13], 0);
+    if (e > 0)
+        lept_bignum_mul_add(a, pow5[e], 0);
+}
+
+//a = a * 2^e
+static void lept_bignum_shl(lept_bignum* a, int e){
+    int words = e / 32, bits = e % 32, i;
+    if (a->n == 0)
+        return;
+    assert(a->n + words + 1 <= LEPT_BIGNUM_LIMBS);
+    if (bits) {
+        a->limb[a->n] = 0;
+        for (i = a->n; i > 0; i--)
+            a->limb[i] = (a->limb[i] << bits) | (a->limb[i - 1] >> (32 - bits));
+        a->limb[0] <<= bits;
+        if (a->limb[a->n])
+            a->n++;
+    }
+    if (words) {
+        memmove(a->limb + words, a->limb, a->n * sizeof(uint32_t));
+        memset(a->limb, 0, words * sizeof(uint32_t));
+        a->n += words;
+    }
+}
+
+//a = u
+static void lept_bignum_set_u64(lept_bignum* a, uint64_t u){
+    a->limb[0] = (uint32_t)u;
+    a->limb[1] = (uint32_t)(u >> 32);
+    a->n = a->limb[1] ? 2 : (a->limb[0] ? 1 : 0);
+}
+
+//r = a + b
+static void lept_bignum_add(lept_bignum* r, const lept_bignum* a, const lept_bignum* b){
+    uint64_t carry = 0;
+    int i, n = a->n > b->n ? a->n : b->n;
+    for (i = 0; i < n; i++) {
+        carry += (uint64_t)(i < a->n ? a->limb[i] : 0) + (i < b->n ? b->limb[i] : 0);
+        r->limb[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        assert(n < LEPT_BIGNUM_LIMBS);
+        r->limb[n++] = (uint32_t)carry;
+    }
+    r->n = n;
+}
+
+//a = a - b, 要求a >= b
+static void lept_bignum_sub(lept_bignum* a, const lept_bignum* b){
+    uint64_t borrow = 0;
+    int i;
+    for (i = 0; i < a->n; i++) {
+        uint64_t d = (uint64_t)a->limb[i] - (i < b->n ? b->limb[i] : 0) - borrow;
+        a->limb[i] = (uint32_t)d;
+        borrow = (d >> 32) & 1;
+    }
+    while (a->n > 0 && a->limb[a->n - 1] == 0)
+        a->n--;
+}
+
+static int lept_bignum_cmp(const lept_bignum* a, const lept_bignum* b){
+    int i;
+    if (a->n != b->n)
+        return a->n < b->n ? -1 : 1;
+    for (i = a->n - 1; i >= 0; i--)
+        if (a->limb[i] != b->limb[i])
+            return a->limb[i] < b->limb[i] ? -1 : 1;
+    return 0;
+}
+
+//p到digits_end是校验过的整数和小数部分(不含符号), exponent是指数部分的值,
+//bits是截断之后的有效数字得到的结果, 返回正确舍入的结果(不含符号位)
+static uint64_t lept_decimal_slow(const char* p, const char* digits_end, int64_t exponent, uint64_t bits){
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+        10000000, 100000000, 1000000000 };
+    lept_bignum d, h;
+    int64_t q = exponent;
+    int kept = 0, in_fraction = 0, sticky = 0, chunk_len = 0, e2, cmp;
+    uint32_t chunk = 0;
+    uint64_t m;
+
+    //累加有效数字d, 数值为 d * 10^q, 每9位数字做一次大整数乘法
+    d.n = 0;
+    for (; p < digits_end; p++) {
+        if (*p == '.') {
+            in_fraction = 1;
+        }
+        else if (kept == 0 && *p == '0') {
+            if (in_fraction) q--;
+        }
+        else if (kept < LEPT_BIGNUM_DIGITS) {
+            chunk = chunk * 10 + (uint32_t)(*p - '0');
+            if (++chunk_len == 9) {
+                lept_bignum_mul_add(&d, pow10[9], chunk);
+                chunk = 0;
+                chunk_len = 0;
+            }
+            kept++;
+            if (in_fraction) q--;
+        }
+        else {
+            if (!in_fraction) q++;
+            sticky |= *p != '0';
+        }
+    }
+    if (chunk_len)
+        lept_bignum_mul_add(&d, pow10[chunk_len], chunk);
+
+    //bits表示的数值为 m * 2^e2, 和下一个double的中点为 (2m+1) * 2^(e2-1)
+    e2 = (int)(bits >> 52);
+    m = bits & (((uint64_t)1 << 52) - 1);
+    if (e2 == 0)
+        e2 = 1;
+    else
+        m |= (uint64_t)1 << 52;
+    e2 -= 1075 + 1;
+    m = 2 * m + 1;
+    h.limb[0] = (uint32_t)m;
+    h.limb[1] = (uint32_t)(m >> 32);
+    h.n = h.limb[1] ? 2 : 1;
+
+    //比较 d * 10^q 和 h * 2^e2, 即 d * 5^q * 2^(q-e2) 和 h, 负的幂移到另一边
+    if (q >= 0)
+        lept_bignum_pow5(&d, (int)q);
+    else
+        lept_bignum_pow5(&h, (int)-q);
+    if (q >= e2)
+        lept_bignum_shl(&d, (int)(q - e2));
+    else
+        lept_bignum_shl(&h, (int)(e2 - q));
+    cmp = lept_bignum_cmp(&d, &h);
+    //恰好等于中点时向偶数舍入
+    if (cmp > 0 || (cmp == 0 && (sticky || (bits & 1))))
+        bits++;
+    return bits;
+}
+
+//判断p是否指向json文本范围内的一个数字字符
+#define ISDIGIT(p) ((p) < end && '0' <= *(p) && *(p) <= '9')
+#define ISDIGIT1TO9(p) ((p) < end && '1' <= *(p) && *(p) <= '9')
+
+//把一位十进制数字累加到有效数字w中, 最多保留19位, 超出的数字只记录是否被截断
+#define LEPT_ADD_DIGIT(ch, in_fraction) \
+    do { \
+        unsigned digit_ = (unsigned)((ch) - '0'); \
+        if (w == 0 && digit_ == 0) { \
+            if (in_fraction) q--; \
+        } \
+        else if (digits < 19) { \
+            w = w * 10 + digit_; \
+            digits++; \
+            if (in_fraction) q--; \
+        } \
+        else { \
+            if (!(in_fraction)) q++; \
+            truncated |= digit_ != 0; \
+        } \
+    } while(0)
+
+static int lept_parse_double(lept_content* c, lept_value* v){
     /*校验部分*/
     //将字符串中的数字转换为double,可包含正负号、小数点或E(e)来表示指数部分
+    //校验的同时累加有效数字w和十进制指数q, 数值为 w * 10^q
 
     const char* p = c->json;
+    const char* end = c->end;
+    const char* digits_end;
+    uint64_t w = 0;
+    int64_t q = 0, exponent = 0;
+    int digits = 0, truncated = 0, negative = 0;
     /*验证正负号*/
-    if(*p == '-') p++;
+    if(p < end && *p == '-') {
+        negative = 1;
+        p++;
+    }
     /*验证整数*/
-    if(*p == '0') {
+    if(p < end && *p == '0') {
         p++;
     }
     else{
-        if( !('1' <= *p && *p <= '9') ) return LEPT_PARSE_INVALID_VALUE;
+        if( !ISDIGIT1TO9(p) ) return LEPT_PARSE_INVALID_VALUE;
 
-        for(p++; '0' <= *p && *p <= '9'; p++);
+        for(; ISDIGIT(p); p++)
+            LEPT_ADD_DIGIT(*p, 0);
     }
     /*验证小数*/
-    if(*p == '.'){
+    if(p < end && *p == '.'){
         p++;
-        if( !('0' <= *p && *p <= '9') ) return LEPT_PARSE_INVALID_VALUE;
-        for(p++; '0' <= *p && *p <= '9'; p++);
+        if( !ISDIGIT(p) ) return LEPT_PARSE_INVALID_VALUE;
+        for(; ISDIGIT(p); p++)
+            LEPT_ADD_DIGIT(*p, 1);
     }
     /*验证指数*/
-    if(*p == 'e' || *p == 'E'){
+    digits_end = p;
+    if(p < end && (*p == 'e' || *p == 'E')){
+        int exp_negative = 0;
         p++;
-        if(*p == '+' || *p == '-')p++;
-        if( !('0' <= *p && *p <= '9') ) return LEPT_PARSE_INVALID_VALUE;
-        for(p++; '0' <= *p && *p <= '9'; p++);
+        if(p < end && (*p == '+' || *p == '-'))
+            exp_negative = *p++ == '-';
+        if( !ISDIGIT(p) ) return LEPT_PARSE_INVALID_VALUE;
+        //指数用64位累加, 饱和在2^59防止溢出; 有效数字的位移不会超过文本长度, 合并之后也不会溢出
+        for(; ISDIGIT(p); p++)
+            if (exponent < ((int64_t)1 << 59))
+                exponent = exponent * 10 + (*p - '0');
+        if (exp_negative)
+            exponent = -exponent;
     }
+    //和小数点的位移合并之后才限制大小, 超出这个范围的结果必然是0或者溢出
+    q += exponent;
+    if (q > 100000) q = 100000;
+    if (q < -100000) q = -100000;
 
-    errno = 0;
-    v->u.n = strtod(c->json, NULL);
-    //当strtod的结果产生的值太大而无法用其返回类型表示时，函数将返回此HUGE_VAL。
-    //通过将 errno 设置为 ERANGE 来发出信号。<errno.h>
-    //产生溢出时，函数的计算结果可能等于 HUGE_VAL，也可能等于 -HUGE_VAL。<math.h>
-    if(errno == ERANGE && (v->u.n == HUGE_VAL || v->u.n == -HUGE_VAL) ) 
+    if (!lept_decimal_to_double(w, (int)q, negative, truncated, &v->u.n)) {
+        uint64_t bits = lept_decimal_slow(c->json + negative, digits_end, exponent, lept_eisel_lemire(w, (int)q));
+        if (negative)
+            bits |= (uint64_t)1 << 63;
+        memcpy(&v->u.n, &bits, sizeof(v->u.n));
+    }
+    //结果太大而无法用double表示时, 得到的是正负无穷大
+    if(v->u.n == HUGE_VAL || v->u.n == -HUGE_VAL)
         return LEPT_PARSE_NUMBER_TOO_BIG;
     c->json = p;
     v->type = LEPT_NUMBER;
@@ -116,6 +543,75 @@ static double lept_parse_double(lept_content* c, lept_value* v){
 }
 
 
+/*string扫描部分*/
+//返回掩码中最低位的1的位置(mask不为0)
+#if defined(LEPT_SCAN_AVX2) || defined(LEPT_SCAN_SSE2)
+static unsigned lept_first_bit(unsigned mask){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+//判断单个字符在json字符串中是否需要特殊处理: '"', '\\' 或者小于0x20的控制字符
+#define LEPT_STRING_SPECIAL(ch) ((ch) == '\"' || (ch) == '\\' || (unsigned char)(ch) < 0x20)
+
+//在[p, end)中查找第一个需要特殊处理的字符, 返回其位置, 没有找到时返回end;
+//这样两个特殊字符之间无需转义的连续字符可以一次性拷贝, 而不是逐个字节压入缓冲区
+static const char* lept_scan_string(const char* p, const char* end){
+#if defined(LEPT_SCAN_AVX2)
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i ctrl  = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        //无符号比较 x <= 0x1F 等价于 min(x, 0x1F) == x
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, slash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, ctrl), x));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask != 0)
+            return p + lept_first_bit(mask);
+    }
+#elif defined(LEPT_SCAN_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl  = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, ctrl), x));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask != 0)
+            return p + lept_first_bit(mask);
+    }
+#else
+    //SWAR: 把size_t当作多个字节的向量, 通过经典的"haszero"技巧判断一个字中是否含有特殊字符
+    //命中之后再逐字节定位, 因此不依赖字节序
+    const size_t ones  = (size_t)-1 / 0xFF;  /* 0x0101...01 */
+    const size_t highs = ones * 0x80;        /* 0x8080...80 */
+    for (; (size_t)(end - p) >= sizeof(size_t); p += sizeof(size_t)) {
+        size_t x, q, b, hit;
+        memcpy(&x, p, sizeof(x));
+        q = x ^ (ones * '\"');
+        b = x ^ (ones * '\\');
+        hit = ((q - ones) & ~q) | ((b - ones) & ~b) | ((x - ones * 0x20) & ~x);
+        if ((hit & highs) != 0)
+            break;
+    }
+#endif
+    //剩余不足一个向量宽度的字节逐个判断
+    while (p < end && !LEPT_STRING_SPECIAL(*p))
+        p++;
+    return p;
+}
+
+
 /*string解析部分*/
 //解析 JSON 字符串时，因为在开始时不能知道字符串的长度，
 //而又需要进行转义，所以需要一个临时缓冲区去存储解析后的结果
@@ -126,6 +622,13 @@ static void* lept_content_push(lept_content* c, size_t size){
 
     //当空间不足时进行重新分配内存
     if(c->top + size >= c->size){
+        //输出缓冲区的大小是固定的, 写满时先把已有的内容交给writer
+        if(c->out){
+            lept_content_flush(c);
+            assert(size < c->size);
+            c->top = size;
+            return c->stack;
+        }
         //c->size为0时初始化大小
         if(c->size == 0) c->size = LEPT_PARSE_STACK_INIT_SIZE; //初始化大小为256byte
 
@@ -133,7 +636,7 @@ static void* lept_content_push(lept_content* c, size_t size){
             c->size += c->size >> 1; /*大小右移动1位, 等同于c->size*1.5, 也就是每次扩大1.5倍*/
         }
         //初次申请空间, 或者重新分配空间大小;
-        c->stack = (char*)realloc(c->stack, c->size);//c->statck初始为null,之后使用realloc重新分配
+        c->stack = (char*)LEPT_REALLOC(c->stack, c->size);//c->statck初始为null,之后使用realloc重新分配
     }
     //返回当前空间中指向容器顶部的指针
     ret = c->stack + c->top;
@@ -149,13 +652,90 @@ static void* lept_content_pop(lept_content* c, size_t size){
     return c->stack + (c->top -= size);
 }
 
+/*arena分配部分*/
+//内存块头部, 后面紧跟着可以分配的空间
+struct lept_arena_chunk{
+    lept_arena_chunk* next; //下一个内存块
+    size_t size;            //内存块中可分配空间的大小
+};
+
+void lept_arena_init(lept_arena* a, size_t chunk_size){
+    assert(a != NULL);
+    a->head = a->cur = NULL;
+    a->used = 0;
+    a->chunk_size = chunk_size ? chunk_size : LEPT_ARENA_CHUNK_SIZE;
+}
+
+//从arena中分配size字节的空间
+//当前内存块不足时, 优先复用重置之前留下的下一个内存块, 否则申请新的内存块插入到当前块之后
+static void* lept_arena_alloc(lept_arena* a, size_t size){
+    void* ret;
+    size = (size + LEPT_ARENA_ALIGN - 1) & ~(size_t)(LEPT_ARENA_ALIGN - 1);
+    if(a->cur == NULL || a->used + size > a->cur->size){
+        lept_arena_chunk* next = a->cur ? a->cur->next : a->head;
+        if(next != NULL && next->size >= size){
+            a->cur = next;
+        }
+        else{
+            size_t n = size > a->chunk_size ? size : a->chunk_size;
+            lept_arena_chunk* chunk = (lept_arena_chunk*)LEPT_MALLOC(sizeof(lept_arena_chunk) + n);
+            assert(chunk != NULL);
+            chunk->size = n;
+            chunk->next = next;
+            if(a->cur) a->cur->next = chunk;
+            else a->head = chunk;
+            a->cur = chunk;
+        }
+        a->used = 0;
+    }
+    ret = (char*)(a->cur + 1) + a->used;
+    a->used += size;
+    return ret;
+}
+
+//重置只需要回到第一个内存块, 时间复杂度为O(1)
+void lept_arena_reset(lept_arena* a){
+    assert(a != NULL);
+    a->cur = a->head;
+    a->used = 0;
+}
+
+void lept_arena_free(lept_arena* a){
+    lept_arena_chunk* chunk;
+    assert(a != NULL);
+    chunk = a->head;
+    while(chunk != NULL){
+        lept_arena_chunk* next = chunk->next;
+        LEPT_FREE(chunk);
+        chunk = next;
+    }
+    a->head = a->cur = NULL;
+    a->used = 0;
+}
+
+//为解析出的节点申请动态空间: 使用arena解析时从arena中分配, 否则使用malloc
+static void* lept_content_alloc(lept_content* c, size_t size){
+    void* ret;
+    if(c->arena)
+        return lept_arena_alloc(c->arena, size);
+    ret = LEPT_MALLOC(size);
+    assert(ret != NULL);
+    return ret;
+}
+
+//释放解析出错时残留的键值空间, arena中的空间由arena统一回收
+static void lept_content_free(lept_content* c, void* p){
+    if(!c->arena)
+        LEPT_FREE(p);
+}
+
 //解析4位十六进制整数为Unicode码点
-static const char* lept_parse_hex4(const char* p , unsigned* u){
+static const char* lept_parse_hex4(const char* p, const char* end, unsigned* u){
     int i;
     *u = 0;
     //将\uXXXX中的十六进制字符解析为数字, 并存储于u中;
     for (i = 0; i < 4; i++) {
-        char ch = *p++;
+        char ch = p < end ? *p++ : '\0';
         *u <<= 4;
         if      (ch >= '0' && ch <= '9')  *u |= ch - '0';
         else if (ch >= 'A' && ch <= 'F')  *u |= ch - 'A' + 10;
@@ -195,15 +775,40 @@ static void lept_encode_utf8(lept_content* c, unsigned u){
     }
 }
 
+//lept_parse_string_raw解析出的字符串str是否直接指向json文本(没有转义字符): 此时它紧挨在结尾的'"'之前
+#define LEPT_STRING_IN_JSON(c, str, len) ((str) == (c)->json - 1 - (len))
+
 //解析json中的字符串
 static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
     unsigned u, u2;
     size_t head = c->top;   //当前栈顶位置索引
+    const char* p;
+    const char* end = c->end;
     assert( *(c->json) == '\"');
     c->json++;
-    const char* p = c->json;
+    p = c->json;
+    //没有转义字符的字符串不需要经过缓冲区, str直接指向json文本, 见LEPT_STRING_IN_JSON
+    {
+        const char* q = lept_scan_string(p, end);
+        if (q != end && *q == '\"') {
+            *str = (char*)p;
+            *len = (size_t)(q - p);
+            c->json = q + 1;
+            return LEPT_PARSE_OK;
+        }
+    }
     while(1){
-        char ch = *p++;
+        //无需转义的连续字符整段拷贝进缓冲区
+        const char* q = lept_scan_string(p, end);
+        char ch;
+        if (q != p) {
+            PUTS(c, p, (size_t)(q - p));
+            p = q;
+        }
+        //到达json文本的结尾仍然没有遇到'"'
+        if (p == end)
+            STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
+        ch = *p++;
         switch(ch){
             case '\"':
                 *len = c->top - head; //计算当前容器中包含的字符长度
@@ -212,7 +817,7 @@ static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
                 c->json = p;
                 return LEPT_PARSE_OK;
             case '\\':
-                switch (*p++) {
+                switch (p < end ? *p++ : '\0') {
                     case '\"': PUTC(c, '\"'); break;
                     case '\\': PUTC(c, '\\'); break;
                     case '/':  PUTC(c, '/' ); break;
@@ -223,17 +828,17 @@ static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
                     case 't':  PUTC(c, '\t'); break;
                     case 'u':
                         //遇到 `\u` 转义时，调用 `lept_parse_hex4()` 解析 4 位十六进数字，存储为码点 `u`。
-                        if( !(p = lept_parse_hex4(p,&u)) ) 
+                        if( !(p = lept_parse_hex4(p, end, &u)) ) 
                             STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
                         
                         //然后，我们用下列公式把代理对 (H, L) 变换成真实的码点：
                         //codepoint = 0x10000 + (H − 0xD800) × 0x400 + (L − 0xDC00)
                         if (u >= 0xD800 && u <= 0xDBFF) { /* surrogate pair */
-                            if (*p++ != '\\')
+                            if (end - p < 2 || *p++ != '\\')
                                 STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
                             if (*p++ != 'u')
                                 STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            if (!(p = lept_parse_hex4(p, &u2)))
+                            if (!(p = lept_parse_hex4(p, end, &u2)))
                                 STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
                             if (u2 < 0xDC00 || u2 > 0xDFFF)
                                 STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
@@ -247,8 +852,6 @@ static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
                         STRING_ERROR(LEPT_PARSE_INVALID_STRING_ESCAPE);
                 }
                 break;
-            case '\0':
-                STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
             default:
                 //handle invalid char
                 //无需转义的字符中 unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
@@ -257,6 +860,7 @@ static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
                 //可显示的字符范围是0x20~0x7E;
                 //0x20以下的字符和0x7F字符(DEL)都是不可见的控制字符;
                 //0x7F以上是需要额外处理的Unicode字符范围;
+                //json文本中间出现的'\0'同样是无效的控制字符
                 if ((unsigned char)ch < 0x20) 
                     STRING_ERROR(LEPT_PARSE_INVALID_STRING_CHAR);
                 //将无需转义的, 且可显示的ASCII字符存入缓冲区容器中;
@@ -265,182 +869,115 @@ static int lept_parse_string_raw(lept_content* c, char** str, size_t* len){
     }
 }
 
+//字符串的内容和长度, 短字符串存放在节点中(LEPT_VALUE_INLINE)
+#define LEPT_STRING_PTR(v) ((v)->flags & LEPT_VALUE_INLINE ? (v)->u.ss.s : (v)->u.s.s)
+#define LEPT_STRING_LEN(v) ((v)->flags & LEPT_VALUE_INLINE ? (size_t)(v)->u.ss.len : (v)->u.s.len)
+//能够存放在节点中的字符串的最大长度, 64位平台上是14
+#define LEPT_INLINE_MAX (sizeof(((lept_value*)0)->u.ss.s) - 1)
+
+static void lept_set_inline_string(lept_value* v, const char* s, size_t len){
+    assert(len <= LEPT_INLINE_MAX);
+    memcpy(v->u.ss.s, s, len);
+    v->u.ss.s[len] = '\0';
+    v->u.ss.len = (unsigned char)len;
+    v->type = LEPT_STRING;
+    v->flags = LEPT_VALUE_INLINE;
+}
+
 static int lept_parse_string(lept_content* c, lept_value* v){
     int ret;
     char* s;
     size_t len;
     ret = lept_parse_string_raw(c, &s, &len);
-    if( ret == LEPT_PARSE_OK ){
-        lept_set_string(v, s, len);
+    if (ret == LEPT_PARSE_OK && c->view && LEPT_STRING_IN_JSON(c, s, len)) {
+        v->u.s.s = s;
+        v->u.s.len = len;
+        v->type = LEPT_STRING;
+        v->flags = LEPT_VALUE_VIEW;
+    }
+    else if (ret == LEPT_PARSE_OK && len <= LEPT_INLINE_MAX)
+        lept_set_inline_string(v, s, len);
+    else if( ret == LEPT_PARSE_OK ){
+        v->u.s.s = (char*)lept_content_alloc(c, len + 1);
+        if (len) memcpy(v->u.s.s, s, len);
+        v->u.s.s[len] = '\0';
+        v->u.s.len = len;
+        v->type = LEPT_STRING;
+        v->flags = c->arena ? LEPT_VALUE_ARENA : 0;
     }
     return ret;
 }
 
 
-static int lept_parse_array(lept_content* c, lept_value* v){
-    assert(v != NULL && c != NULL);
-    assert(*c->json == '[');
-    
-    //元素个数初始化
-    size_t size = 0;
-    size_t i = 0;
-    int ret;
-    c->json++;
-    //去掉开头的空白符
-    lept_parse_whiteSpace(c);
-    //特殊情况, 内部没有元素
-    if(*c->json == ']'){
-        c->json++;
-        v->type = LEPT_ARRAY;
-        v->u.a.size = 0;
+//把缓冲区顶部的size个元素移动到新申请的动态内存空间, 组成数组节点
+static void lept_pop_array(lept_content* c, lept_value* v, size_t size){
+    v->type = LEPT_ARRAY;
+    v->flags = c->arena ? LEPT_VALUE_ARENA : 0;
+    v->u.a.size = size;
+    if (size == 0) {
         v->u.a.e = NULL;
-        return LEPT_PARSE_OK;
-    }
-    //开始解析数组内部元素
-    while(1){
-        lept_value e; //定义一个临时节点用以保存当前解析的数组成员数据
-        lept_init(&e);
-        ret = lept_parse_value(c, &e); //解析后存于临时节点e中;
-        if(ret != LEPT_PARSE_OK){
-            break;
-        }
-        //将临时节点e的数据拷贝进缓冲区顶部; 每次拷贝一个节点大小;
-        memcpy(lept_content_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
-        size++; //数组元素个数加一;
-        lept_parse_whiteSpace(c);
-        //通过逗号确定数组成员
-        if (*c->json == ','){
-            c->json++;
-            lept_parse_whiteSpace(c);
-            if(*c->json == ']'){
-                //由于json中的数组中不支持尾部','逗号, 返回缺少数组元素的错误码
-                ret = LEPT_PARSE_MISS_ARRAY_ELEMENT;
-                break; 
-            }
-        }
-        //通过尾部']'确定数组结尾
-        else if (*c->json == ']') {
-            c->json++;
-            v->type = LEPT_ARRAY;
-            v->u.a.size = size;
-            size *= sizeof(lept_value); //size*节点大小获得总大小
-            //将缓冲区中的数据存储于新申请的动态内存空间;
-            v->u.a.e = (lept_value*)malloc(size);
-            memcpy(v->u.a.e, lept_content_pop(c, size), size);
-            return LEPT_PARSE_OK;
-        }
-        else{
-            //解析缺少逗号或方括号
-            ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
-            break;
-        }
+        return;
     }
-    /* Pop and free values on the stack */
-    for (i = 0; i < size; i++)
-        lept_free((lept_value*)lept_content_pop(c, sizeof(lept_value)));
-    return ret;
+    size *= sizeof(lept_value); //size*节点大小获得总大小
+    v->u.a.e = (lept_value*)lept_content_alloc(c, size);
+    memcpy(v->u.a.e, lept_content_pop(c, size), size);
 }
 
-
-static int lept_parse_object(lept_content* c, lept_value* v){
-    int ret;
-    lept_member m; //临时对象成员
-    size_t i, size;
-
-    EXPECT(c, '{');
-    lept_parse_whiteSpace(c);
-
-    //当对象内部没有成员时
-    if(*c->json == '}'){
-        c->json++;
-        v->type = LEPT_OBJECT;
-        v->u.o.m = NULL;
-        v->u.o.size = 0;
-        return LEPT_PARSE_OK;
+/*对象哈希索引部分*/
+//FNV-1a哈希
+static unsigned lept_hash_key(const char* key, size_t len){
+    unsigned h = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
     }
-    
-    //初始化成员键值
-    m.key = NULL;
-    //初始化成员个数
-    size = 0;
-    while(1){
-        char* str;
-        lept_init(&m.v); //初始化成员value的节点数据结构
+    return h;
+}
 
-        /* parse key */
-        if (*c->json != '"') {
-            ret = LEPT_PARSE_MISS_KEY; //键值中缺少的'"';
-            break;
-        }
-        //解析键值的字符串, 获取键值的指针str, 和键值的长度;
-        ret = lept_parse_string_raw(c, &str, &m.keyLen);
-        if(ret != LEPT_PARSE_OK){
-            break;
-        }
-        //额外申请空间存储键值
-        m.key = (char*)malloc(m.keyLen + 1);
-        assert(m.key != NULL);
-        //拷贝键值到内存空间
-        memcpy(m.key, str, m.keyLen);
-        //记得加上字符串的结尾'\0'
-        m.key[m.keyLen + 1] = '\0';
+//哈希表的槽数: 不小于成员个数两倍的2的幂, 保证装载率不超过一半
+static size_t lept_index_capacity(size_t size){
+    size_t cap = 4;
+    while (cap < size * 2)
+        cap <<= 1;
+    return cap;
+}
 
-        /* parse ws colon ws */
-        lept_parse_whiteSpace(c);
-        if (*c->json != ':') {
-            ret = LEPT_PARSE_MISS_COLON; //当对象成员缺少冒号时
-            break;
-        }
-        c->json++;
-        lept_parse_whiteSpace(c);
-        //解析成员的实际值, 存储到临时的成员数据结构中
-        ret = lept_parse_value(c, &m.v);
-        if(ret != LEPT_PARSE_OK){
-            break;
-        }
-        //将临时成员数据结构存放进缓冲区
-        void* push = lept_content_push(c, sizeof(lept_member));
-        memcpy(push, &m, sizeof(lept_member));
-        size++;
-        
-        //初始化临时的成员数据结构键值指针
-        m.key = NULL;
-        lept_parse_whiteSpace(c);
-        
-        //解析多个成员的情况;
-        if (*c->json == ',') {
-            c->json++;
-            lept_parse_whiteSpace(c);
-        }
-        else if (*c->json == '}') {  //解析结束时将所有的成员数据结构全部从缓冲区中移除, 并存储于申请的空间;
-            size_t s = sizeof(lept_member) * size;
-            c->json++;
-            v->type = LEPT_OBJECT;
-            v->u.o.size = size;
-            v->u.o.m = (lept_member*)malloc(s);
-            memcpy(v->u.o.m, lept_content_pop(c, s), s);
-            return LEPT_PARSE_OK;
-        }
-        else {
-            ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET; //对象解析时缺少冒号或者右括号;
-            break;
-        }
-    }
+//哈希索引位于成员数组之后, 每个槽存储成员的索引加一, 0表示空槽
+#define LEPT_OBJECT_INDEX(v) ((size_t*)((v)->u.o.m + (v)->u.o.size))
 
-     /* Pop and free members on the stack */
-    // 只要以上情况中出现一个错误就会执行以下代码
-    // 释放临时成员数据结构中键值的空间;
-    // 然后挨个释放缓冲区中每个成员数据结构的键值空间和value值空间;
-    free(m.key);
-    for (i = 0; i < size; i++) {
-        lept_member* m = (lept_member*)lept_content_pop(c, sizeof(lept_member));
-        free(m->key);
-        lept_free(&m->v);
+//使用开放定址法(线性探测)建立哈希索引, 重复的键值中第一个成员先插入, 查找时也就先被找到
+static void lept_build_object_index(lept_value* v){
+    size_t* slots = LEPT_OBJECT_INDEX(v);
+    size_t mask = lept_index_capacity(v->u.o.size) - 1;
+    size_t i;
+    memset(slots, 0, (mask + 1) * sizeof(size_t));
+    for (i = 0; i < v->u.o.size; i++) {
+        size_t h = lept_hash_key(v->u.o.m[i].key, v->u.o.m[i].keyLen) & mask;
+        while (slots[h] != 0)
+            h = (h + 1) & mask;
+        slots[h] = i + 1;
     }
-    v->type = LEPT_NULL;
-    return ret;
+    v->flags |= LEPT_VALUE_INDEXED;
 }
 
+//把缓冲区顶部的size个成员移动到新申请的动态内存空间, 组成对象节点
+static void lept_pop_object(lept_content* c, lept_value* v, size_t size){
+    size_t s = sizeof(lept_member) * size;
+    //开启索引且成员较多时, 哈希索引和成员数组在同一块空间中分配
+    size_t index_size = c->index && size >= LEPT_OBJECT_INDEX_THRESHOLD ? lept_index_capacity(size) * sizeof(size_t) : 0;
+    v->type = LEPT_OBJECT;
+    v->flags = c->arena ? LEPT_VALUE_ARENA : 0;
+    v->u.o.size = size;
+    if (size == 0) {
+        v->u.o.m = NULL;
+        return;
+    }
+    v->u.o.m = (lept_member*)lept_content_alloc(c, s + index_size);
+    memcpy(v->u.o.m, lept_content_pop(c, s), s);
+    if (index_size)
+        lept_build_object_index(v);
+}
 
 static int lept_parse_iteral(lept_content* c, lept_value* v, int type){
     if(type == LEPT_NULL){
@@ -458,90 +995,2046 @@ static int lept_parse_iteral(lept_content* c, lept_value* v, int type){
     else if(type == LEPT_STRING){
         return lept_parse_string(c, v);
     }
-    else if(type == LEPT_ARRAY){
-        return lept_parse_array(c, v);
-    }
-    else if(type == LEPT_OBJECT){
-        return lept_parse_object(c, v);
-    }
     return LEPT_PARSE_INVALID_VALUE;
 }
 
 //判断当前值是否是指定字面量;
-/* value 可能等于 null / false / true */
-static int lept_parse_value(lept_content* c, lept_value* v){
-    const char* p = c->json;
-    switch(*p){
+/* scalar 可能等于 null / false / true / number / string */
+static int lept_parse_scalar(lept_content* c, lept_value* v){
+    switch(PEEK(c)){
         case 'n': return lept_parse_iteral(c, v, LEPT_NULL);  //解析null
         case 'f': return lept_parse_iteral(c, v, LEPT_FALSE); //解析false
         case 't': return lept_parse_iteral(c, v, LEPT_TRUE);  //解析true
         case '"': return lept_parse_iteral(c, v, LEPT_STRING); //解析string
-        case '[': return lept_parse_iteral(c, v, LEPT_ARRAY); // 解析array
-        case '{': return lept_parse_iteral(c, v, LEPT_OBJECT); // 解析对象;
-        case '\0': return LEPT_PARSE_EXCEPT_VALUE; //返回异常值错误
+        //到达结尾时返回异常值错误, 文本中间出现的'\0'是无效值
+        case '\0': return c->json == c->end ? LEPT_PARSE_EXCEPT_VALUE : LEPT_PARSE_INVALID_VALUE;
         default: return lept_parse_iteral(c, v, LEPT_NUMBER);//返回无效错误码 或者解析数字
     }
 }
 
-/* json_text = ws + json + ws  */
-int lept_parse(lept_value* v, const char* json){
-    //使用断言进行判断输入参数是否正常;
-    assert(v != NULL);
+/*数组和对象解析部分*/
+//数组和对象不使用递归解析, 尚未结束的每一层容器在缓冲区中保存一个lept_frame, 它的元素或成员紧跟在它之后;
+//嵌套深度只受LEPT_PARSE_MAX_DEPTH限制, 与C的调用栈无关
+//DOM, SAX和tape解析共用同一个驱动lept_parse_events: 它负责词法, 分隔符, 嵌套和错误码,
+//解析出的值通过lept_emitter中的回调交给各自的后端
+#if defined(__GNUC__)
+#define LEPT_ALWAYS_INLINE __inline__ __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define LEPT_ALWAYS_INLINE __forceinline
+#else
+#define LEPT_ALWAYS_INLINE
+#endif
 
-    int ret;
-    lept_content c;
-    //存储json字符串的当前位置
-    c.json = json;
-    c.stack = NULL;
-    c.size = 0;
-    c.top = 0;
-    //将节点的类型设置为null类型
-    v->type = LEPT_NULL;
-    //解析空白, 将json指针移动到值的位置;
-    lept_parse_whiteSpace(&c);
-    //解析值, 并返回enum值;
-    ret = lept_parse_value(&c, v);
-    if(ret == LEPT_PARSE_OK){
-        lept_parse_whiteSpace(&c);
-        if(*c.json != '\0'){
-            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;//说明json文本还有其他字符;
-        }
-    }
-    assert(c.top == 0); //在释放时，加入了断言确保所有数据都被弹出。
-    free(c.stack);
-    return ret;
-}
+typedef struct{
+    size_t prev;     //上一层容器的lept_frame在缓冲区中的位置
+    size_t size;     //已经完成的元素或成员个数
+    lept_type type;  //LEPT_ARRAY 或 LEPT_OBJECT
+}lept_frame;
 
-//type
-lept_type lept_get_type(const lept_value* v){
-    assert(v != NULL);
-    return v->type;
-}
+#define LEPT_FRAME(c, offset) ((lept_frame*)((c)->stack + (offset)))
 
-//string
-void lept_set_string(lept_value* v, const char* s, size_t len){
-    assert(v != NULL && (s != NULL || len == 0));
-    //释放原来的
-    lept_free(v);
-    //重新申请空间
-    v->u.s.s = (char*)malloc(len + 1);
-    //拷贝
-    memcpy(v->u.s.s, s, len);
-    v->u.s.s[len] = '\0'; //填补结尾空字符
-    v->u.s.len = len;     //字符串长度
-    v->type = LEPT_STRING;
+//后端的回调, 为NULL的回调会被跳过; 返回错误码的回调中止解析
+typedef struct{
+    //解析一个字符串值, c->json指向'"'; DOM解析把结果存入e
+    int (*string)(lept_content* c, void* s, lept_value* e);
+    //null, true, false或数字已经解析到e中
+    int (*scalar)(void* s, const lept_value* e);
+    //解析对象成员的键值, c->json指向'"', 冒号由驱动解析
+    int (*key)(lept_content* c, void* s);
+    //进入一层新的容器, 已经跳过了'['或'{'
+    int (*start)(lept_content* c, void* s, lept_type type);
+    //值e完成, 成为当前容器中的第size个元素或成员
+    void (*element)(lept_content* c, lept_type type, lept_value* e);
+    //结束最内层的容器, 它有size个元素或成员; DOM解析把它们组装成节点e
+    int (*end)(lept_content* c, void* s, lept_type type, size_t size, lept_value* e);
+    //出错时释放depth层尚未结束的容器中的内容, frame为最内层的位置
+    void (*abort)(lept_content* c, size_t frame, size_t depth);
+}lept_emitter;
+
+//进入一层新的容器, frame更新为新容器的位置
+static int lept_push_frame(lept_content* c, size_t* frame, size_t* depth, lept_type type){
+    lept_frame f;
+    if (*depth >= LEPT_PARSE_MAX_DEPTH)
+        return LEPT_PARSE_DEPTH_EXCEEDED;
+    f.prev = *frame;
+    f.size = 0;
+    f.type = type;
+    *frame = c->top;
+    memcpy(lept_content_push(c, sizeof(lept_frame)), &f, sizeof(lept_frame));
+    (*depth)++;
+    return LEPT_PARSE_OK;
 }
 
-size_t lept_get_string_length(const lept_value* v){
-    assert(v != NULL && (v->type == LEPT_STRING) );
-    return v->u.s.len;
+//结束最内层的容器, 交给后端之后弹出它的lept_frame
+static int lept_pop_frame(lept_content* c, const lept_emitter* h, void* s, size_t* frame, size_t* depth, lept_value* e){
+    lept_frame f = *LEPT_FRAME(c, *frame);
+    int ret;
+    if (h->end && (ret = h->end(c, s, f.type, f.size, e)) != LEPT_PARSE_OK)
+        return ret;
+    lept_content_pop(c, sizeof(lept_frame));
+    assert(c->top == *frame);
+    *frame = f.prev;
+    (*depth)--;
+    return LEPT_PARSE_OK;
 }
-const char* lept_get_string(const lept_value* v){
-    assert(v != NULL && (v->type == LEPT_STRING) );
-    return v->u.s.s;
+
+//解析对象成员的键值和冒号
+static int lept_parse_key(lept_content* c, const lept_emitter* h, void* s){
+    int ret;
+    if (PEEK(c) != '"')
+        return LEPT_PARSE_MISS_KEY; //键值中缺少的'"';
+    if ((ret = h->key(c, s)) != LEPT_PARSE_OK)
+        return ret;
+    /* parse ws colon ws */
+    lept_parse_whiteSpace(c);
+    if (PEEK(c) != ':')
+        return LEPT_PARSE_MISS_COLON; //当对象成员缺少冒号时
+    c->json++;
+    lept_parse_whiteSpace(c);
+    return LEPT_PARSE_OK;
 }
 
-//bool类型
+//跳过一个数组或对象, 只检查括号是否配对并跳过其中的字符串, 文本范围记录在惰性节点v中;
+//嵌套深度从这个容器开始计算
+static int lept_skip_container(lept_content* c, lept_value* v){
+    const char* p = c->json;
+    const char* end = c->end;
+    size_t depth = 0;
+    lept_type type = *p == '[' ? LEPT_ARRAY : LEPT_OBJECT;
+    while (p < end) {
+        switch (*p++) {
+            case '[':
+            case '{':
+                if (++depth > LEPT_PARSE_MAX_DEPTH)
+                    return LEPT_PARSE_DEPTH_EXCEEDED;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0) {
+                    v->type = type;
+                    v->flags = LEPT_VALUE_LAZY;
+                    v->u.l.json = c->json;
+                    v->u.l.len = (size_t)(p - c->json);
+                    c->json = p;
+                    return LEPT_PARSE_OK;
+                }
+                break;
+            case '"':
+                //字符串中的括号不计入; 转义和无效字符留到展开时再检查
+                while ((p = lept_scan_string(p, end)) != end && *p != '"')
+                    p = (*p == '\\' && end - p > 1) ? p + 2 : p + 1;
+                if (p == end)
+                    return LEPT_PARSE_MISS_QUOTATION_MARK;
+                p++;
+                break;
+            default:
+                break;
+        }
+    }
+    return type == LEPT_ARRAY ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+}
+
+/* value = null / false / true / number / string / array / object */
+//解析一个值, 依次把其中的每个值交给后端; e用来存放刚刚完成的值, 成功时是整个值本身
+//出错时释放尚未结束的容器, 缓冲区恢复到调用之前的大小
+//驱动在每个后端的入口处展开, h是常量, 编译器可以把回调直接内联
+static LEPT_ALWAYS_INLINE int lept_parse_events(lept_content* c, const lept_emitter* h, void* s, lept_value* e){
+    size_t head = c->top, frame = 0, depth = 0;
+    lept_type type;
+    int ret;
+    while (1) {
+        /* 解析一个值: 标量直接解析完成, 遇到'['或'{'则进入新的一层 */
+        lept_init(e);
+        if ((PEEK(c) == '[' || PEEK(c) == '{') && c->lazy && depth > 0) {
+            //惰性解析: 内层的数组和对象只记录文本范围
+            if ((ret = lept_skip_container(c, e)) != LEPT_PARSE_OK)
+                break;
+        }
+        else if (PEEK(c) == '[' || PEEK(c) == '{') {
+            type = *c->json == '[' ? LEPT_ARRAY : LEPT_OBJECT;
+            if ((ret = lept_push_frame(c, &frame, &depth, type)) != LEPT_PARSE_OK)
+                break;
+            c->json++;
+            if (h->start && (ret = h->start(c, s, type)) != LEPT_PARSE_OK)
+                break;
+            lept_parse_whiteSpace(c);
+            //特殊情况, 内部没有元素
+            if (PEEK(c) == (type == LEPT_ARRAY ? ']' : '}')) {
+                c->json++;
+                if ((ret = lept_pop_frame(c, h, s, &frame, &depth, e)) != LEPT_PARSE_OK)
+                    break;
+            }
+            else if (type == LEPT_ARRAY)
+                continue;
+            else {
+                if ((ret = lept_parse_key(c, h, s)) != LEPT_PARSE_OK)
+                    break;
+                continue;
+            }
+        }
+        else if (PEEK(c) == '"') {
+            if ((ret = h->string(c, s, e)) != LEPT_PARSE_OK)
+                break;
+        }
+        else {
+            if ((ret = lept_parse_scalar(c, e)) != LEPT_PARSE_OK)
+                break;
+            if (h->scalar && (ret = h->scalar(s, e)) != LEPT_PARSE_OK)
+                break;
+        }
+
+        /* 把完成的值交给所在的容器, 容器结束时它本身又成为一个完成的值, 直到需要解析下一个值 */
+        while (1) {
+            if (depth == 0)
+                return LEPT_PARSE_OK;
+            //element可能扩容缓冲区, 之后不能再使用指向lept_frame的指针
+            type = LEPT_FRAME(c, frame)->type;
+            LEPT_FRAME(c, frame)->size++;
+            if (h->element)
+                h->element(c, type, e);
+            lept_parse_whiteSpace(c);
+            //通过逗号确定下一个元素或成员
+            if (PEEK(c) == ',') {
+                c->json++;
+                lept_parse_whiteSpace(c);
+                //由于json中的数组中不支持尾部','逗号, 返回缺少数组元素的错误码
+                if (type == LEPT_ARRAY)
+                    ret = PEEK(c) == ']' ? LEPT_PARSE_MISS_ARRAY_ELEMENT : LEPT_PARSE_OK;
+                else
+                    ret = lept_parse_key(c, h, s);
+                break;
+            }
+            //通过尾部']'或'}'确定容器结尾
+            else if (PEEK(c) == (type == LEPT_ARRAY ? ']' : '}')) {
+                c->json++;
+                if ((ret = lept_pop_frame(c, h, s, &frame, &depth, e)) != LEPT_PARSE_OK)
+                    break;
+            }
+            else {
+                ret = type == LEPT_ARRAY ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                break;
+            }
+        }
+        if (ret != LEPT_PARSE_OK)
+            break;
+    }
+    if (h->abort)
+        h->abort(c, frame, depth);
+    c->top = head;
+    return ret;
+}
+
+/*DOM解析的后端*/
+static int lept_dom_string(lept_content* c, void* s, lept_value* e){
+    (void)s;
+    return lept_parse_string(c, e);
+}
+
+//解析对象成员的键值, 并把成员压入缓冲区, 成员的值在解析完成之后再填入
+static int lept_dom_key(lept_content* c, void* s){
+    lept_member m;
+    char* str;
+    size_t len;
+    int ret;
+    (void)s;
+    //解析键值的字符串, 获取键值的指针str, 和键值的长度;
+    if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+        return ret;
+    if ((uint64_t)len > UINT32_MAX)
+        return LEPT_PARSE_KEY_TOO_LONG;
+    m.keyLen = (uint32_t)len;
+    if (c->view && LEPT_STRING_IN_JSON(c, str, m.keyLen)) {
+        m.key = str;
+        m.keyFlags = LEPT_VALUE_VIEW;
+    }
+    //池满了时与不使用池相同, 单独分配键值
+    else if (c->intern && (m.key = (char*)lept_intern_n(c->intern, str, m.keyLen)) != NULL)
+        m.keyFlags = LEPT_VALUE_INTERNED;
+    else {
+        //额外申请空间存储键值, 记得加上字符串的结尾'\0'
+        m.key = (char*)lept_content_alloc(c, m.keyLen + 1);
+        if (m.keyLen) memcpy(m.key, str, m.keyLen);
+        m.key[m.keyLen] = '\0';
+        m.keyFlags = 0;
+    }
+    lept_init(&m.v);
+    memcpy(lept_content_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+    return LEPT_PARSE_OK;
+}
+
+static void lept_dom_element(lept_content* c, lept_type type, lept_value* e){
+    //数组: 将值拷贝进缓冲区顶部; 对象: 成员在解析键值时已经压入缓冲区, 这里填入它的值
+    if (type == LEPT_ARRAY)
+        memcpy(lept_content_push(c, sizeof(lept_value)), e, sizeof(lept_value));
+    else
+        memcpy(&((lept_member*)(c->stack + c->top - sizeof(lept_member)))->v, e, sizeof(lept_value));
+}
+
+//把容器的元素或成员组装成节点e
+static int lept_dom_end(lept_content* c, void* s, lept_type type, size_t size, lept_value* e){
+    (void)s;
+    if (type == LEPT_ARRAY)
+        lept_pop_array(c, e, size);
+    else
+        lept_pop_object(c, e, size);
+    return LEPT_PARSE_OK;
+}
+
+//从最内层开始释放所有尚未结束的容器中的元素和成员; 对象中最后一个成员可能只有键值, 它的值仍是null
+static void lept_free_frames(lept_content* c, size_t frame, size_t depth){
+    for (; depth > 0; depth--) {
+        lept_frame f = *LEPT_FRAME(c, frame);
+        while (c->top > frame + sizeof(lept_frame)) {
+            if (f.type == LEPT_ARRAY)
+                lept_free((lept_value*)lept_content_pop(c, sizeof(lept_value)));
+            else {
+                lept_member* m = (lept_member*)lept_content_pop(c, sizeof(lept_member));
+                if (!(m->keyFlags & (LEPT_VALUE_VIEW | LEPT_VALUE_INTERNED)))
+                    lept_content_free(c, m->key);
+                lept_free(&m->v);
+            }
+        }
+        lept_content_pop(c, sizeof(lept_frame));
+        frame = f.prev;
+    }
+}
+
+static const lept_emitter lept_dom_emitter = {
+    lept_dom_string, NULL, lept_dom_key, NULL, lept_dom_element, lept_dom_end, lept_free_frames
+};
+
+static int lept_parse_value(lept_content* c, lept_value* v){
+    lept_value e;
+    int ret = lept_parse_events(c, &lept_dom_emitter, NULL, &e);
+    if (ret == LEPT_PARSE_OK)
+        *v = e;
+    return ret;
+}
+
+/* json_text = ws + json + ws  */
+//解析c中的一个根节点以及它前后的空白, c的堆栈可以是之前留下的, 返回时堆栈为空但容量保留
+static int lept_parse_root_value(lept_content* c, lept_value* v){
+    int ret;
+    //将节点的类型设置为null类型
+    lept_init(v);
+    //解析空白, 将json指针移动到值的位置;
+    lept_parse_whiteSpace(c);
+    //解析值, 并返回enum值;
+    ret = lept_parse_value(c, v);
+    if(ret == LEPT_PARSE_OK)
+        lept_parse_whiteSpace(c);
+    assert(c->top == 0); //在释放时，加入了断言确保所有数据都被弹出。
+    return ret;
+}
+
+//解析c中的整个json文本, 根节点之后不能再有其他字符
+static int lept_parse_root(lept_content* c, lept_value* v){
+    int ret = lept_parse_root_value(c, v);
+    if(ret == LEPT_PARSE_OK && c->json != c->end)
+        ret = LEPT_PARSE_ROOT_NOT_SINGULAR;//说明json文本还有其他字符;
+    return ret;
+}
+
+static int lept_parse_json(lept_value* v, const char* json, size_t len, lept_arena* arena, int view, int lazy){
+    int ret;
+    lept_content c;
+    //存储json字符串的当前位置和结尾位置
+    lept_content_init(&c, json, len);
+    c.arena = arena;
+    c.view = view;
+    c.lazy = lazy;
+    ret = lept_parse_root(&c, v);
+    LEPT_FREE(c.stack);
+    return ret;
+}
+
+int lept_parse(lept_value* v, const char* json){
+    //使用断言进行判断输入参数是否正常;
+    assert(v != NULL && json != NULL);
+    return lept_parse_json(v, json, strlen(json), NULL, 0, 0);
+}
+
+int lept_parse_n(lept_value* v, const char* json, size_t len){
+    assert(v != NULL && (json != NULL || len == 0));
+    return lept_parse_json(v, json, len, NULL, 0, 0);
+}
+
+int lept_parse_view(lept_value* v, const char* json, size_t len){
+    assert(v != NULL && (json != NULL || len == 0));
+    return lept_parse_json(v, json, len, NULL, 1, 0);
+}
+
+int lept_parse_lazy(lept_value* v, const char* json, size_t len){
+    assert(v != NULL && (json != NULL || len == 0));
+    return lept_parse_json(v, json, len, NULL, 0, 1);
+}
+
+int lept_expand(lept_value* v){
+    lept_value e;
+    int ret;
+    assert(v != NULL);
+    if (!(v->flags & LEPT_VALUE_LAZY))
+        return LEPT_PARSE_OK;
+    //文本范围恰好是一个容器, 展开时它的子容器仍然是惰性的; 出错时v保持不变
+    ret = lept_parse_json(&e, v->u.l.json, v->u.l.len, NULL, 0, 1);
+    if (ret == LEPT_PARSE_OK)
+        *v = e;
+    return ret;
+}
+
+//只读的接口不修改节点, 访问数组和对象之前必须已经用lept_expand展开
+#define LEPT_EXPANDED(v) (!((v)->flags & LEPT_VALUE_LAZY))
+
+//把文件映射为只读的内存视图; 空文件无法映射, 得到长度为0的空文本
+#ifdef _WIN32
+static int lept_file_map(const char* path, const char** data, size_t* size){
+    HANDLE file, mapping;
+    LARGE_INTEGER file_size;
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return LEPT_PARSE_FILE_ERROR;
+    if(!GetFileSizeEx(file, &file_size) || (unsigned long long)file_size.QuadPart > (size_t)-1){
+        CloseHandle(file);
+        return LEPT_PARSE_FILE_ERROR;
+    }
+    if(file_size.QuadPart == 0){
+        CloseHandle(file);
+        *data = "";
+        *size = 0;
+        return LEPT_PARSE_OK;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL)
+        return LEPT_PARSE_FILE_ERROR;
+    *data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(*data == NULL)
+        return LEPT_PARSE_FILE_ERROR;
+    *size = (size_t)file_size.QuadPart;
+    return LEPT_PARSE_OK;
+}
+
+static void lept_file_unmap(const char* data, size_t size){
+    if(size > 0)
+        UnmapViewOfFile(data);
+}
+#else
+static int lept_file_map(const char* path, const char** data, size_t* size){
+    struct stat st;
+    void* p;
+    int fd;
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return LEPT_PARSE_FILE_ERROR;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (off_t)(*size = (size_t)st.st_size) != st.st_size){
+        close(fd);
+        return LEPT_PARSE_FILE_ERROR;
+    }
+    if(*size == 0){
+        close(fd);
+        *data = "";
+        return LEPT_PARSE_OK;
+    }
+    p = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+        return LEPT_PARSE_FILE_ERROR;
+    //解析是从头到尾顺序读取的, 提示内核提前预读
+    posix_madvise(p, *size, POSIX_MADV_SEQUENTIAL);
+    *data = (const char*)p;
+    return LEPT_PARSE_OK;
+}
+
+static void lept_file_unmap(const char* data, size_t size){
+    if(size > 0)
+        munmap((void*)data, size);
+}
+#endif
+
+//文件映射的只读视图在解析完成后立即解除, 解析出的节点不会引用文件中的内容
+int lept_parse_file(lept_value* v, const char* path){
+    const char* data;
+    size_t size;
+    int ret;
+    assert(v != NULL && path != NULL);
+    lept_init(v);
+    if((ret = lept_file_map(path, &data, &size)) != LEPT_PARSE_OK)
+        return ret;
+    ret = lept_parse_n(v, data, size);
+    lept_file_unmap(data, size);
+    return ret;
+}
+
+int lept_parse_arena(lept_arena* a, lept_value* v, const char* json){
+    assert(a != NULL && v != NULL && json != NULL);
+    return lept_parse_json(v, json, strlen(json), a, 0, 0);
+}
+
+/*SAX事件解析部分*/
+//与DOM解析共用驱动lept_parse_events, 只是把结果交给回调而不是存入节点, 不会申请节点的动态空间
+//回调返回0时中止解析
+#define SAX_CALL(h, cb, args) \
+    do { if ((h)->cb && !(h)->cb args) return LEPT_PARSE_TERMINATED; } while(0)
+
+typedef struct{
+    const lept_handler* h;
+    void* ctx;
+}lept_sax;
+
+static int lept_sax_string(lept_content* c, void* s, lept_value* e){
+    lept_sax* x = (lept_sax*)s;
+    char* str;
+    size_t len;
+    int ret;
+    (void)e;
+    if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+        return ret;
+    SAX_CALL(x->h, string, (x->ctx, str, len));
+    return LEPT_PARSE_OK;
+}
+
+static int lept_sax_scalar(void* s, const lept_value* e){
+    lept_sax* x = (lept_sax*)s;
+    switch (e->type) {
+        case LEPT_NULL:   SAX_CALL(x->h, null_value, (x->ctx)); break;
+        case LEPT_FALSE:  SAX_CALL(x->h, boolean, (x->ctx, 0)); break;
+        case LEPT_TRUE:   SAX_CALL(x->h, boolean, (x->ctx, 1)); break;
+        default:          SAX_CALL(x->h, number, (x->ctx, e->u.n)); break;
+    }
+    return LEPT_PARSE_OK;
+}
+
+static int lept_sax_key(lept_content* c, void* s){
+    lept_sax* x = (lept_sax*)s;
+    char* str;
+    size_t len;
+    int ret;
+    if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+        return ret;
+    SAX_CALL(x->h, key, (x->ctx, str, len));
+    return LEPT_PARSE_OK;
+}
+
+static int lept_sax_start(lept_content* c, void* s, lept_type type){
+    lept_sax* x = (lept_sax*)s;
+    (void)c;
+    if (type == LEPT_ARRAY)
+        SAX_CALL(x->h, start_array, (x->ctx));
+    else
+        SAX_CALL(x->h, start_object, (x->ctx));
+    return LEPT_PARSE_OK;
+}
+
+static int lept_sax_end(lept_content* c, void* s, lept_type type, size_t size, lept_value* e){
+    lept_sax* x = (lept_sax*)s;
+    (void)c;
+    (void)e;
+    if (type == LEPT_ARRAY)
+        SAX_CALL(x->h, end_array, (x->ctx, size));
+    else
+        SAX_CALL(x->h, end_object, (x->ctx, size));
+    return LEPT_PARSE_OK;
+}
+
+//缓冲区中的lept_frame不持有动态空间, 出错时由驱动直接恢复缓冲区
+static const lept_emitter lept_sax_emitter = {
+    lept_sax_string, lept_sax_scalar, lept_sax_key, lept_sax_start, NULL, lept_sax_end, NULL
+};
+
+static int lept_sax_parse_value(lept_content* c, const lept_handler* h, void* ctx){
+    lept_sax x;
+    lept_value e; //标量值暂存在栈上的节点中, 不会申请动态空间
+    x.h = h;
+    x.ctx = ctx;
+    return lept_parse_events(c, &lept_sax_emitter, &x, &e);
+}
+
+int lept_parse_sax(const lept_handler* h, void* ctx, const char* json, size_t len){
+    int ret;
+    lept_content c;
+    assert(h != NULL && (json != NULL || len == 0));
+    lept_content_init(&c, json, len);
+    lept_parse_whiteSpace(&c);
+    ret = lept_sax_parse_value(&c, h, ctx);
+    if (ret == LEPT_PARSE_OK) {
+        lept_parse_whiteSpace(&c);
+        if (c.json != c.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    LEPT_FREE(c.stack);
+    return ret;
+}
+
+/*tape解析部分*/
+//与DOM和SAX解析共用驱动lept_parse_events, 结果依次写入另一个缓冲区, 这个缓冲区本身就是最终的tape
+#define LEPT_TAPE_TAG_SHIFT 56
+#define LEPT_TAPE_PAYLOAD_MASK ((((uint64_t)1) << LEPT_TAPE_TAG_SHIFT) - 1)
+#define LEPT_TAPE_WORD(type, payload) (((uint64_t)(type) << LEPT_TAPE_TAG_SHIFT) | (uint64_t)(payload))
+#define LEPT_TAPE_TYPE(v) ((lept_type)((v)->w >> LEPT_TAPE_TAG_SHIFT))
+#define LEPT_TAPE_PAYLOAD(v) ((size_t)((v)->w & LEPT_TAPE_PAYLOAD_MASK))
+//缓冲区中第i个字
+#define LEPT_TAPE_AT(c, i) ((lept_tape_value*)(c)->stack + (i))
+
+static void lept_tape_put(lept_content* c, uint64_t w){
+    ((lept_tape_value*)lept_content_push(c, sizeof(lept_tape_value)))->w = w;
+}
+
+//字符串占用的字数: 标签字, 以及补齐到8字节的字符串和'\0'
+#define LEPT_TAPE_STRING_WORDS(len) (1 + (len) / sizeof(lept_tape_value) + 1)
+
+typedef struct{
+    lept_content t;  //tape的内容, 与驱动的缓冲区分开
+    size_t frame;    //最内层的尚未结束的容器的标签字在tape中的位置
+}lept_tape_builder;
+
+//没有转义的字符串直接从json文本复制, 含有转义字符的字符串从驱动的缓冲区复制
+static int lept_tape_string(lept_content* c, void* s, lept_value* e){
+    lept_tape_builder* b = (lept_tape_builder*)s;
+    size_t len, size;
+    char* str;
+    char* dst;
+    int ret;
+    (void)e;
+    if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+        return ret;
+    size = (LEPT_TAPE_STRING_WORDS(len) - 1) * sizeof(lept_tape_value);
+    lept_tape_put(&b->t, LEPT_TAPE_WORD(LEPT_STRING, len));
+    dst = (char*)lept_content_push(&b->t, size);
+    if (len) memcpy(dst, str, len);
+    memset(dst + len, 0, size - len);
+    return LEPT_PARSE_OK;
+}
+
+static int lept_tape_key(lept_content* c, void* s){
+    return lept_tape_string(c, s, NULL);
+}
+
+static int lept_tape_scalar(void* s, const lept_value* e){
+    lept_tape_builder* b = (lept_tape_builder*)s;
+    if (e->type == LEPT_NUMBER) {
+        //数字占用两个字: 标签字和double
+        lept_tape_value* w = (lept_tape_value*)lept_content_push(&b->t, 2 * sizeof(lept_tape_value));
+        w[0].w = LEPT_TAPE_WORD(LEPT_NUMBER, 0);
+        memcpy(&w[1], &e->u.n, sizeof(double));
+    }
+    else
+        lept_tape_put(&b->t, LEPT_TAPE_WORD(e->type, 0));
+    return LEPT_PARSE_OK;
+}
+
+//尚未结束的容器的标签字暂时记录上一层容器的位置, 结束时再填入占用的字数和元素或成员个数
+static int lept_tape_start(lept_content* c, void* s, lept_type type){
+    lept_tape_builder* b = (lept_tape_builder*)s;
+    (void)c;
+    lept_tape_put(&b->t, LEPT_TAPE_WORD(type, b->frame));
+    lept_tape_put(&b->t, 0);
+    b->frame = b->t.top / sizeof(lept_tape_value) - 2;
+    return LEPT_PARSE_OK;
+}
+
+static int lept_tape_end(lept_content* c, void* s, lept_type type, size_t size, lept_value* e){
+    lept_tape_builder* b = (lept_tape_builder*)s;
+    lept_tape_value* f = LEPT_TAPE_AT(&b->t, b->frame);
+    size_t prev = LEPT_TAPE_PAYLOAD(f);
+    (void)c;
+    (void)e;
+    f[0].w = LEPT_TAPE_WORD(type, b->t.top / sizeof(lept_tape_value) - b->frame);
+    f[1].w = size;
+    b->frame = prev;
+    return LEPT_PARSE_OK;
+}
+
+//出错时整个tape都会被释放, 不需要逐层清理
+static const lept_emitter lept_tape_emitter = {
+    lept_tape_string, lept_tape_scalar, lept_tape_key, lept_tape_start, NULL, lept_tape_end, NULL
+};
+
+int lept_parse_tape(lept_tape* t, const char* json, size_t len){
+    int ret;
+    lept_content c;
+    lept_tape_builder b;
+    lept_value e;
+    assert(t != NULL && (json != NULL || len == 0));
+    lept_content_init(&c, json, len);
+    b.t = c;
+    //tape通常与json文本的大小相近, 预先按文本长度申请以减少扩容的次数
+    b.t.size = (len + LEPT_PARSE_STACK_INIT_SIZE) & ~(size_t)(sizeof(lept_tape_value) - 1);
+    b.t.stack = (char*)LEPT_MALLOC(b.t.size);
+    b.frame = 0;
+    lept_parse_whiteSpace(&c);
+    ret = lept_parse_events(&c, &lept_tape_emitter, &b, &e);
+    if (ret == LEPT_PARSE_OK) {
+        lept_parse_whiteSpace(&c);
+        if (c.json != c.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    LEPT_FREE(c.stack);
+    if (ret != LEPT_PARSE_OK) {
+        LEPT_FREE(b.t.stack);
+        t->words = NULL;
+        t->size = 0;
+        return ret;
+    }
+    t->words = (lept_tape_value*)b.t.stack;
+    t->size = b.t.top / sizeof(lept_tape_value);
+    return LEPT_PARSE_OK;
+}
+
+void lept_tape_free(lept_tape* t){
+    assert(t != NULL);
+    LEPT_FREE(t->words);
+    t->words = NULL;
+    t->size = 0;
+}
+
+const lept_tape_value* lept_tape_root(const lept_tape* t){
+    assert(t != NULL && t->words != NULL);
+    return t->words;
+}
+
+const lept_tape_value* lept_tape_next(const lept_tape_value* v){
+    assert(v != NULL);
+    switch (LEPT_TAPE_TYPE(v)) {
+        case LEPT_NUMBER: return v + 2;
+        case LEPT_STRING: return v + LEPT_TAPE_STRING_WORDS(LEPT_TAPE_PAYLOAD(v));
+        case LEPT_ARRAY:
+        case LEPT_OBJECT: return v + LEPT_TAPE_PAYLOAD(v);
+        default:          return v + 1;
+    }
+}
+
+lept_type lept_tape_get_type(const lept_tape_value* v){
+    assert(v != NULL);
+    return LEPT_TAPE_TYPE(v);
+}
+
+int lept_tape_get_boolean(const lept_tape_value* v){
+    assert(v != NULL && (LEPT_TAPE_TYPE(v) == LEPT_TRUE || LEPT_TAPE_TYPE(v) == LEPT_FALSE));
+    return LEPT_TAPE_TYPE(v) == LEPT_TRUE;
+}
+
+double lept_tape_get_number(const lept_tape_value* v){
+    double n;
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_NUMBER);
+    memcpy(&n, v + 1, sizeof(double));
+    return n;
+}
+
+const char* lept_tape_get_string(const lept_tape_value* v){
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_STRING);
+    return (const char*)(v + 1);
+}
+
+size_t lept_tape_get_string_length(const lept_tape_value* v){
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_STRING);
+    return LEPT_TAPE_PAYLOAD(v);
+}
+
+size_t lept_tape_get_array_size(const lept_tape_value* v){
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_ARRAY);
+    return (size_t)v[1].w;
+}
+
+const lept_tape_value* lept_tape_get_array_element(const lept_tape_value* v, size_t index){
+    const lept_tape_value* e;
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_ARRAY);
+    assert(index < v[1].w);
+    for (e = v + 2; index > 0; index--)
+        e = lept_tape_next(e);
+    return e;
+}
+
+size_t lept_tape_get_object_size(const lept_tape_value* v){
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_OBJECT);
+    return (size_t)v[1].w;
+}
+
+//第index个成员的键值, 成员的值紧跟在它之后
+static const lept_tape_value* lept_tape_member(const lept_tape_value* v, size_t index){
+    const lept_tape_value* k;
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_OBJECT);
+    assert(index < v[1].w);
+    for (k = v + 2; index > 0; index--)
+        k = lept_tape_next(lept_tape_next(k));
+    return k;
+}
+
+const char* lept_tape_get_object_key(const lept_tape_value* v, size_t index){
+    return lept_tape_get_string(lept_tape_member(v, index));
+}
+
+size_t lept_tape_get_object_key_length(const lept_tape_value* v, size_t index){
+    return lept_tape_get_string_length(lept_tape_member(v, index));
+}
+
+const lept_tape_value* lept_tape_get_object_value(const lept_tape_value* v, size_t index){
+    return lept_tape_next(lept_tape_member(v, index));
+}
+
+const lept_tape_value* lept_tape_find_object_value(const lept_tape_value* v, const char* key, size_t klen){
+    const lept_tape_value* k;
+    size_t i;
+    assert(v != NULL && LEPT_TAPE_TYPE(v) == LEPT_OBJECT && (key != NULL || klen == 0));
+    for (i = 0, k = v + 2; i < v[1].w; i++) {
+        const lept_tape_value* value = lept_tape_next(k);
+        if (LEPT_TAPE_PAYLOAD(k) == klen && (klen == 0 || memcmp(k + 1, key, klen) == 0))
+            return value;
+        k = lept_tape_next(value);
+    }
+    return NULL;
+}
+
+/*增量解析部分*/
+//解析器在两次输入之间只保存语法状态和尚未结束的容器, 完整出现在一段输入中的标量直接在原处解析,
+//只有被段边界截断的标量才会复制到pending中, 拼接完整后再交给lept_parse_scalar解析
+
+//尚未结束的一层数组或对象
+struct lept_parser_frame{
+    lept_type type; //LEPT_ARRAY 或 LEPT_OBJECT
+    size_t size;    //已经压入缓冲区的元素或成员的个数
+};
+
+//下一个期待的语法成分
+enum{
+    LEPT_PARSER_VALUE,        //值
+    LEPT_PARSER_ARRAY_FIRST,  //'['之后的值或者']'
+    LEPT_PARSER_ARRAY_NEXT,   //数组元素之后的','或者']'
+    LEPT_PARSER_OBJECT_FIRST, //'{'之后的键值或者'}'
+    LEPT_PARSER_OBJECT_KEY,   //','之后的键值
+    LEPT_PARSER_OBJECT_COLON, //键值之后的':'
+    LEPT_PARSER_OBJECT_NEXT,  //成员之后的','或者'}'
+    LEPT_PARSER_DONE          //根节点已经完成, 只允许空白
+};
+
+void lept_parser_init(lept_parser* p){
+    assert(p != NULL);
+    memset(p, 0, sizeof(*p));
+    lept_init(&p->root);
+    p->state = LEPT_PARSER_VALUE;
+}
+
+//释放缓冲区中尚未组装完成的节点, 回到初始状态, 保留已经申请的空间以便复用
+static void lept_parser_reset(lept_parser* p){
+    lept_content* c = &p->c;
+    size_t i;
+    while (p->depth > 0) {
+        lept_parser_frame* f = &p->frames[--p->depth];
+        for (i = 0; i < f->size; i++) {
+            if (f->type == LEPT_ARRAY)
+                lept_free((lept_value*)lept_content_pop(c, sizeof(lept_value)));
+            else {
+                lept_member* m = (lept_member*)lept_content_pop(c, sizeof(lept_member));
+                if (!(m->keyFlags & LEPT_VALUE_INTERNED))
+                    lept_content_free(c, m->key);
+                lept_free(&m->v);
+            }
+        }
+    }
+    assert(c->top == 0);
+    lept_free(&p->root);
+    p->pending_len = 0;
+    p->token = 0;
+    p->escaped = 0;
+    p->state = LEPT_PARSER_VALUE;
+    p->error = LEPT_PARSE_OK;
+}
+
+void lept_parser_free(lept_parser* p){
+    assert(p != NULL);
+    lept_parser_reset(p);
+    LEPT_FREE(p->c.stack);
+    LEPT_FREE(p->frames);
+    LEPT_FREE(p->pending);
+    lept_parser_init(p);
+}
+
+static void lept_parser_push_frame(lept_parser* p, lept_type type){
+    if (p->depth == p->frame_cap) {
+        p->frame_cap = p->frame_cap ? p->frame_cap + (p->frame_cap >> 1) : 16;
+        p->frames = (lept_parser_frame*)LEPT_REALLOC(p->frames, p->frame_cap * sizeof(lept_parser_frame));
+        assert(p->frames != NULL);
+    }
+    p->frames[p->depth].type = type;
+    p->frames[p->depth].size = 0;
+    p->depth++;
+}
+
+static void lept_parser_append(lept_parser* p, const char* s, size_t len){
+    if (p->pending_len + len > p->pending_cap) {
+        if (p->pending_cap == 0) p->pending_cap = LEPT_PARSE_STACK_INIT_SIZE;
+        while (p->pending_len + len > p->pending_cap)
+            p->pending_cap += p->pending_cap >> 1;
+        p->pending = (char*)LEPT_REALLOC(p->pending, p->pending_cap);
+        assert(p->pending != NULL);
+    }
+    if (len) memcpy(p->pending + p->pending_len, s, len);
+    p->pending_len += len;
+}
+
+//一个完整的值交给上一层容器; 没有上一层时成为根节点
+static void lept_parser_emit(lept_parser* p, const lept_value* v){
+    lept_parser_frame* f;
+    if (p->depth == 0) {
+        p->root = *v;
+        p->state = LEPT_PARSER_DONE;
+        return;
+    }
+    f = &p->frames[p->depth - 1];
+    if (f->type == LEPT_ARRAY) {
+        memcpy(lept_content_push(&p->c, sizeof(lept_value)), v, sizeof(lept_value));
+        f->size++;
+        p->state = LEPT_PARSER_ARRAY_NEXT;
+    }
+    else {
+        //成员在解析键值时已经压入缓冲区, 这里填入它的值
+        ((lept_member*)(p->c.stack + p->c.top - sizeof(lept_member)))->v = *v;
+        p->state = LEPT_PARSER_OBJECT_NEXT;
+    }
+}
+
+//结束最内层的容器
+static void lept_parser_close(lept_parser* p){
+    lept_parser_frame* f = &p->frames[--p->depth];
+    lept_value v;
+    lept_init(&v);
+    if (f->type == LEPT_ARRAY)
+        lept_pop_array(&p->c, &v, f->size);
+    else
+        lept_pop_object(&p->c, &v, f->size);
+    lept_parser_emit(p, &v);
+}
+
+//寻找从s开始的标量的结尾, 找不到时(标量延续到下一段输入)返回NULL
+static const char* lept_parser_token_end(lept_parser* p, const char* s, const char* end){
+    switch (p->token) {
+        case '"':
+            //只需要区分转义字符, 字符串内容的合法性留给lept_parse_string_raw检查;
+            //遇到控制字符时提前结束, 让错误尽早报告
+            while (1) {
+                if (p->escaped) {
+                    if (s == end) return NULL;
+                    s++;
+                    p->escaped = 0;
+                }
+                s = lept_scan_string(s, end);
+                if (s == end) return NULL;
+                if (*s != '\\') return s + 1;
+                p->escaped = 1;
+                s++;
+            }
+        case 'n':
+        case 't':
+        case 'f': {
+            size_t need = (p->token == 'f' ? 5 : 4) - p->pending_len;
+            return (size_t)(end - s) >= need ? s + need : NULL;
+        }
+        default:
+            while (s < end && ((*s >= '0' && *s <= '9') || *s == '-' || *s == '+' || *s == '.' || *s == 'e' || *s == 'E'))
+                s++;
+            return s < end ? s : NULL;
+    }
+}
+
+//解析一个完整的标量: 对象的键值, 或者值
+static int lept_parser_scalar(lept_parser* p){
+    lept_content* c = &p->c;
+    int ret;
+    if (p->state == LEPT_PARSER_OBJECT_FIRST || p->state == LEPT_PARSER_OBJECT_KEY) {
+        lept_member m;
+        char* str;
+        size_t len;
+        if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+            return ret;
+        if ((uint64_t)len > UINT32_MAX)
+            return LEPT_PARSE_KEY_TOO_LONG;
+        m.keyLen = (uint32_t)len;
+        if (c->intern && (m.key = (char*)lept_intern_n(c->intern, str, m.keyLen)) != NULL)
+            m.keyFlags = LEPT_VALUE_INTERNED;
+        else {
+            m.key = (char*)lept_content_alloc(c, m.keyLen + 1);
+            if (m.keyLen) memcpy(m.key, str, m.keyLen);
+            m.key[m.keyLen] = '\0';
+            m.keyFlags = 0;
+        }
+        lept_init(&m.v);
+        memcpy(lept_content_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+        p->frames[p->depth - 1].size++;
+        p->state = LEPT_PARSER_OBJECT_COLON;
+    }
+    else {
+        lept_value v;
+        lept_init(&v);
+        if ((ret = lept_parse_scalar(c, &v)) != LEPT_PARSE_OK)
+            return ret;
+        lept_parser_emit(p, &v);
+    }
+    return LEPT_PARSE_OK;
+}
+
+//处理一段输入; last不为0时表示输入已经结束
+static int lept_parser_run(lept_parser* p, const char* json, size_t len, int last){
+    lept_content* c = &p->c;
+    const char* end = json + len;
+    const char* q;
+    int ret;
+
+    //开始一个新的json文本时取用解析器的arena, 驻留池和索引设置, 解析到一半时修改它们不影响这个文本
+    if (p->depth == 0 && p->state == LEPT_PARSER_VALUE && !p->token) {
+        c->arena = p->arena;
+        c->intern = p->intern;
+        c->index = p->index;
+    }
+
+    //先把被截断的标量补充完整
+    if (p->token) {
+        q = lept_parser_token_end(p, json, end);
+        if (q == NULL) {
+            lept_parser_append(p, json, len);
+            if (!last)
+                return LEPT_PARSE_OK;
+            q = end;
+        }
+        else
+            lept_parser_append(p, json, (size_t)(q - json));
+        p->token = 0;
+        c->json = p->pending;
+        c->end = p->pending + p->pending_len;
+        if ((ret = lept_parser_scalar(p)) != LEPT_PARSE_OK)
+            return ret;
+        //数字之后残留的字符(如"1.2.3"中的".3")是标量之后不允许出现的字符
+        if (c->json != c->end)
+            return p->state == LEPT_PARSER_DONE ? LEPT_PARSE_ROOT_NOT_SINGULAR :
+                   p->state == LEPT_PARSER_ARRAY_NEXT ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+        p->pending_len = 0;
+        json = q;
+    }
+    c->json = json;
+    c->end = end;
+
+    while (1) {
+        lept_parse_whiteSpace(c);
+        //这一段输入已经处理完毕, 到达真正的结尾时按照'\0'处理, 得到和lept_parse相同的错误码
+        if (c->json == c->end && !last)
+            return LEPT_PARSE_OK;
+        switch (p->state) {
+            case LEPT_PARSER_DONE:
+                return c->json == c->end ? LEPT_PARSE_OK : LEPT_PARSE_ROOT_NOT_SINGULAR;
+            case LEPT_PARSER_ARRAY_NEXT:
+                if (PEEK(c) == ',') {
+                    c->json++;
+                    p->state = LEPT_PARSER_VALUE;
+                }
+                else if (PEEK(c) == ']') {
+                    c->json++;
+                    lept_parser_close(p);
+                }
+                else
+                    return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                continue;
+            case LEPT_PARSER_OBJECT_NEXT:
+                if (PEEK(c) == ',') {
+                    c->json++;
+                    p->state = LEPT_PARSER_OBJECT_KEY;
+                }
+                else if (PEEK(c) == '}') {
+                    c->json++;
+                    lept_parser_close(p);
+                }
+                else
+                    return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                continue;
+            case LEPT_PARSER_OBJECT_COLON:
+                if (PEEK(c) != ':')
+                    return LEPT_PARSE_MISS_COLON;
+                c->json++;
+                p->state = LEPT_PARSER_VALUE;
+                continue;
+            case LEPT_PARSER_OBJECT_FIRST:
+                if (PEEK(c) == '}') {
+                    c->json++;
+                    lept_parser_close(p);
+                    continue;
+                }
+                /* fall through */
+            case LEPT_PARSER_OBJECT_KEY:
+                if (PEEK(c) != '"')
+                    return LEPT_PARSE_MISS_KEY;
+                break;
+            case LEPT_PARSER_ARRAY_FIRST:
+                if (PEEK(c) == ']') {
+                    c->json++;
+                    lept_parser_close(p);
+                    continue;
+                }
+                /* fall through */
+            default:
+                //数组中','之后紧跟']'
+                if (PEEK(c) == ']' && p->state == LEPT_PARSER_VALUE && p->depth > 0 && p->frames[p->depth - 1].type == LEPT_ARRAY)
+                    return LEPT_PARSE_MISS_ARRAY_ELEMENT;
+                if (PEEK(c) == '[' || PEEK(c) == '{') {
+                    if (p->depth >= LEPT_PARSE_MAX_DEPTH)
+                        return LEPT_PARSE_DEPTH_EXCEEDED;
+                    lept_parser_push_frame(p, *c->json == '[' ? LEPT_ARRAY : LEPT_OBJECT);
+                    p->state = *c->json == '[' ? LEPT_PARSER_ARRAY_FIRST : LEPT_PARSER_OBJECT_FIRST;
+                    c->json++;
+                    continue;
+                }
+                break;
+        }
+
+        //标量: 在这一段输入中找到结尾时直接解析, 否则暂存起来等待下一段输入
+        p->token = PEEK(c);
+        p->escaped = 0;
+        p->pending_len = 0;
+        q = lept_parser_token_end(p, p->token == '"' ? c->json + 1 : c->json, c->end);
+        if (q == NULL && !last) {
+            lept_parser_append(p, c->json, (size_t)(c->end - c->json));
+            return LEPT_PARSE_OK;
+        }
+        p->token = 0;
+        if ((ret = lept_parser_scalar(p)) != LEPT_PARSE_OK)
+            return ret;
+    }
+}
+
+int lept_parser_feed(lept_parser* p, const char* chunk, size_t len){
+    assert(p != NULL && (chunk != NULL || len == 0));
+    if (p->error == LEPT_PARSE_OK && len > 0) {
+        p->error = lept_parser_run(p, chunk, len, 0);
+        if (p->error != LEPT_PARSE_OK) {
+            //出错后立即释放已经解析的部分, 只保留错误码
+            int error = p->error;
+            lept_parser_reset(p);
+            p->error = error;
+        }
+    }
+    return p->error;
+}
+
+int lept_parser_finish(lept_parser* p, lept_value* v){
+    int ret;
+    assert(p != NULL && v != NULL);
+    lept_init(v);
+    ret = p->error;
+    if (ret == LEPT_PARSE_OK)
+        ret = lept_parser_run(p, "", 0, 1);
+    if (ret == LEPT_PARSE_OK) {
+        *v = p->root;
+        lept_init(&p->root);
+    }
+    lept_parser_reset(p);
+    return ret;
+}
+
+void lept_parser_set_arena(lept_parser* p, lept_arena* a){
+    assert(p != NULL);
+    p->arena = a;
+}
+
+void lept_parser_set_intern(lept_parser* p, lept_intern* t){
+    assert(p != NULL);
+    p->intern = t;
+}
+
+void lept_parser_set_index(lept_parser* p, int enable){
+    assert(p != NULL);
+    p->index = enable;
+}
+
+//用解析器的堆栈解析[json, end)中的根节点; next为NULL时根节点之后不能再有其他字符,
+//否则*next为根节点和之后的空白的下一个位置
+static int lept_parser_parse_root(lept_parser* p, lept_value* v, const char* json, const char* end, const char** next){
+    lept_content* c;
+    int ret;
+    //增量解析进行到一半时不能借用它的堆栈
+    assert(p->depth == 0 && p->state == LEPT_PARSER_VALUE && p->pending_len == 0);
+    c = &p->c;
+    c->json = json;
+    c->end = end;
+    c->arena = p->arena;
+    c->intern = p->intern;
+    c->index = p->index;
+    if (next == NULL)
+        ret = lept_parse_root(c, v);
+    else {
+        ret = lept_parse_root_value(c, v);
+        *next = c->json;
+    }
+    //堆栈保留给下一次调用, 其他字段恢复成初始状态
+    c->json = c->end = NULL;
+    c->arena = NULL;
+    c->intern = NULL;
+    c->index = 0;
+    return ret;
+}
+
+int lept_parser_parse_n(lept_parser* p, lept_value* v, const char* json, size_t len){
+    assert(p != NULL && v != NULL && (json != NULL || len == 0));
+    return lept_parser_parse_root(p, v, json, json + len, NULL);
+}
+
+int lept_parser_parse_next(lept_parser* p, lept_value* v, const char* json, size_t len, size_t* offset){
+    const char* next;
+    int ret;
+    assert(p != NULL && v != NULL && offset != NULL && (json != NULL || len == 0) && *offset <= len);
+    ret = lept_parser_parse_root(p, v, json + *offset, json + len, &next);
+    if (ret == LEPT_PARSE_OK)
+        *offset = (size_t)(next - json);
+    return ret;
+}
+
+int lept_parser_parse(lept_parser* p, lept_value* v, const char* json){
+    assert(json != NULL);
+    return lept_parser_parse_n(p, v, json, strlen(json));
+}
+
+/*多线程部分*/
+//定义LEPT_NO_THREADS时不创建线程, 所有任务在调用者的线程中依次执行
+typedef void (*lept_task_fn)(void* arg);
+
+#if defined(LEPT_NO_THREADS)
+typedef int lept_mutex;
+#define lept_mutex_init(m) ((void)(m))
+#define lept_mutex_destroy(m) ((void)(m))
+#define lept_mutex_lock(m) ((void)(m))
+#define lept_mutex_unlock(m) ((void)(m))
+#else
+typedef struct{
+    lept_task_fn fn;
+    void* arg;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    int started;
+}lept_task;
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION lept_mutex;
+#define lept_mutex_init(m) InitializeCriticalSection(m)
+#define lept_mutex_destroy(m) DeleteCriticalSection(m)
+#define lept_mutex_lock(m) EnterCriticalSection(m)
+#define lept_mutex_unlock(m) LeaveCriticalSection(m)
+
+static DWORD WINAPI lept_task_main(LPVOID arg){
+    lept_task* t = (lept_task*)arg;
+    t->fn(t->arg);
+    return 0;
+}
+
+static int lept_task_start(lept_task* t){
+    t->thread = CreateThread(NULL, 0, lept_task_main, t, 0, NULL);
+    return t->thread != NULL;
+}
+
+static void lept_task_join(lept_task* t){
+    WaitForSingleObject(t->thread, INFINITE);
+    CloseHandle(t->thread);
+}
+#else
+typedef pthread_mutex_t lept_mutex;
+#define lept_mutex_init(m) pthread_mutex_init(m, NULL)
+#define lept_mutex_destroy(m) pthread_mutex_destroy(m)
+#define lept_mutex_lock(m) pthread_mutex_lock(m)
+#define lept_mutex_unlock(m) pthread_mutex_unlock(m)
+
+static void* lept_task_main(void* arg){
+    lept_task* t = (lept_task*)arg;
+    t->fn(t->arg);
+    return NULL;
+}
+
+static int lept_task_start(lept_task* t){
+    return pthread_create(&t->thread, NULL, lept_task_main, t) == 0;
+}
+
+static void lept_task_join(lept_task* t){
+    pthread_join(t->thread, NULL);
+}
+#endif
+#endif
+
+//可用的处理器个数, 作为默认的线程数
+static size_t lept_processor_count(void){
+#if defined(LEPT_NO_THREADS)
+    return 1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#else
+    return 1;
+#endif
+}
+
+//对args中每个大小为arg_size的参数执行fn: 第一个在当前线程中执行, 其余的各开一个线程, 全部结束后返回;
+//无法创建线程时在当前线程中执行
+static void lept_run_tasks(lept_task_fn fn, void* args, size_t arg_size, size_t n){
+#ifdef LEPT_NO_THREADS
+    size_t i;
+    for (i = 0; i < n; i++)
+        fn((char*)args + i * arg_size);
+#else
+    lept_task* tasks;
+    size_t i;
+    if (n <= 1) {
+        if (n == 1)
+            fn(args);
+        return;
+    }
+    tasks = (lept_task*)LEPT_MALLOC(n * sizeof(lept_task));
+    for (i = 1; i < n; i++) {
+        tasks[i].fn = fn;
+        tasks[i].arg = (char*)args + i * arg_size;
+        if (!(tasks[i].started = lept_task_start(&tasks[i])))
+            fn(tasks[i].arg);
+    }
+    fn(args);
+    for (i = 1; i < n; i++)
+        if (tasks[i].started)
+            lept_task_join(&tasks[i]);
+    LEPT_FREE(tasks);
+#endif
+}
+
+/*NDJSON并行解析部分*/
+//文本按整行切成每个线程一段, 每个线程用自己的lept_parser依次解析段内的记录;
+//先并行统计每段的记录数得到每段第一条记录的序号, 再并行解析, 所以记录的序号与线程的划分无关
+#ifndef LEPT_NDJSON_MIN_CHUNK
+#define LEPT_NDJSON_MIN_CHUNK (64 * 1024) //每个线程至少分到这么多字节, 避免为很短的文本创建线程
+#endif
+
+typedef struct{
+    lept_record_handler fn;
+    void* ctx;
+    lept_value* values; //不为NULL时按序号存入结果, 不调用fn
+    lept_mutex lock;    //保护下面字段的写入
+    size_t failed;      //出错的记录中最小的序号, 没有出错时为(size_t)-1
+    int error;          //序号为failed的记录的错误码
+    int stop;           //fn返回了0
+}lept_ndjson;
+
+//failed和stop只在加锁时写入, 每条记录开始前不加锁读取: 它们只用来提前结束,
+//读到旧值时最多多解析几条记录, 最终结果由线程结束后的值决定
+#if defined(__GNUC__) || defined(__clang__)
+#define LEPT_ATOMIC_LOAD(type, p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define LEPT_ATOMIC_STORE(type, p, x) __atomic_store_n((p), (x), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#define LEPT_ATOMIC_LOAD(type, p) (*(volatile type*)(p))
+#define LEPT_ATOMIC_STORE(type, p, x) (*(volatile type*)(p) = (x))
+#else
+//没有原子读写时加锁读取, 每隔这么多条记录读一次
+#ifndef LEPT_NDJSON_CHECK_INTERVAL
+#define LEPT_NDJSON_CHECK_INTERVAL 64
+#endif
+#define LEPT_ATOMIC_STORE(type, p, x) (*(p) = (x))
+#endif
+
+typedef struct{
+    lept_ndjson* s;
+    const char* begin;  //本段的文本, 以整行为边界
+    const char* end;
+    size_t first;       //本段第一条记录的序号
+    size_t count;       //本段的记录数
+}lept_ndjson_chunk;
+
+//从*p开始找下一条记录, 跳过只有空白的行; 找到时[*begin, *stop)为记录所在的行, *p移到下一行的开头
+static int lept_ndjson_next(const char** p, const char* end, const char** begin, const char** stop){
+    while (*p < end) {
+        const char* b = *p;
+        const char* q = (const char*)memchr(b, '\n', (size_t)(end - b));
+        if (q == NULL)
+            q = end;
+        *p = q < end ? q + 1 : end;
+        while (b < q && (*b == ' ' || *b == '\t' || *b == '\r'))
+            b++;
+        if (b < q) {
+            *begin = b;
+            *stop = q;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void lept_ndjson_count(void* arg){
+    lept_ndjson_chunk* k = (lept_ndjson_chunk*)arg;
+    const char *p = k->begin, *b, *e;
+    k->count = 0;
+    while (lept_ndjson_next(&p, k->end, &b, &e))
+        k->count++;
+}
+
+//是否继续解析序号为i的记录, n为本段已经解析的记录数
+static int lept_ndjson_go(lept_ndjson* s, size_t i, size_t n){
+#ifdef LEPT_ATOMIC_LOAD
+    (void)n;
+    //收集结果时, 序号在最早的错误之后的记录不需要再解析
+    return !LEPT_ATOMIC_LOAD(int, &s->stop) && !(s->values && i > LEPT_ATOMIC_LOAD(size_t, &s->failed));
+#else
+    int go;
+    if (n % LEPT_NDJSON_CHECK_INTERVAL != 0)
+        return 1;
+    lept_mutex_lock(&s->lock);
+    go = !s->stop && !(s->values && i > s->failed);
+    lept_mutex_unlock(&s->lock);
+    return go;
+#endif
+}
+
+static void lept_ndjson_parse(void* arg){
+    lept_ndjson_chunk* k = (lept_ndjson_chunk*)arg;
+    lept_ndjson* s = k->s;
+    lept_parser p;
+    lept_value tmp;
+    const char *q = k->begin, *b, *e;
+    size_t i;
+    int ret, go = 1;
+    lept_parser_init(&p);
+    for (i = k->first; go && lept_ndjson_next(&q, k->end, &b, &e); i++) {
+        lept_value* v = s->values ? &s->values[i] : &tmp;
+        if (!lept_ndjson_go(s, i, i - k->first))
+            break;
+        ret = lept_parser_parse_n(&p, v, b, (size_t)(e - b));
+        if (ret != LEPT_PARSE_OK) {
+            lept_free(v);
+            lept_mutex_lock(&s->lock);
+            if (i < s->failed) {
+                LEPT_ATOMIC_STORE(size_t, &s->failed, i);
+                s->error = ret;
+            }
+            lept_mutex_unlock(&s->lock);
+            if (s->values)
+                break;
+        }
+        if (!s->values) {
+            if (!s->fn(s->ctx, i, v, ret)) {
+                lept_mutex_lock(&s->lock);
+                LEPT_ATOMIC_STORE(int, &s->stop, 1);
+                lept_mutex_unlock(&s->lock);
+                go = 0;
+            }
+            lept_free(v);
+        }
+    }
+    lept_parser_free(&p);
+}
+
+static int lept_ndjson_run(lept_ndjson* s, lept_value* v, const char* json, size_t len, size_t threads){
+    lept_ndjson_chunk* chunks;
+    size_t i, n, total;
+    const char *p, *end = json + len;
+    int ret;
+    if (threads == 0)
+        threads = lept_processor_count();
+    n = len / LEPT_NDJSON_MIN_CHUNK + 1;
+    if (n > threads)
+        n = threads;
+    //在第i * len / n个字节之后的第一个换行处切分
+    chunks = (lept_ndjson_chunk*)LEPT_MALLOC(n * sizeof(lept_ndjson_chunk));
+    for (i = 0, p = json; i < n; i++) {
+        const char* q = i + 1 < n ? json + len / n * (i + 1) : end;
+        if (q < p)
+            q = p;
+        if (q < end && (q = (const char*)memchr(q, '\n', (size_t)(end - q))) != NULL)
+            q++;
+        else
+            q = end;
+        chunks[i].s = s;
+        chunks[i].begin = p;
+        chunks[i].end = p = q;
+    }
+    lept_run_tasks(lept_ndjson_count, chunks, sizeof(lept_ndjson_chunk), n);
+    for (i = 0, total = 0; i < n; i++) {
+        chunks[i].first = total;
+        total += chunks[i].count;
+    }
+    if (v != NULL) {
+        s->values = total > 0 ? (lept_value*)LEPT_MALLOC(total * sizeof(lept_value)) : NULL;
+        for (i = 0; i < total; i++)
+            lept_init(&s->values[i]);
+    }
+    lept_mutex_init(&s->lock);
+    s->failed = (size_t)-1;
+    s->error = LEPT_PARSE_OK;
+    s->stop = 0;
+    if (total > 0)
+        lept_run_tasks(lept_ndjson_parse, chunks, sizeof(lept_ndjson_chunk), n);
+    lept_mutex_destroy(&s->lock);
+    LEPT_FREE(chunks);
+    ret = s->stop ? LEPT_PARSE_TERMINATED : s->error;
+    if (v != NULL) {
+        if (ret == LEPT_PARSE_OK) {
+            v->type = LEPT_ARRAY;
+            v->u.a.e = s->values;
+            v->u.a.size = total;
+        }
+        else {
+            for (i = 0; i < total; i++)
+                lept_free(&s->values[i]);
+            LEPT_FREE(s->values);
+        }
+    }
+    return ret;
+}
+
+int lept_parse_ndjson(lept_value* v, const char* json, size_t len, size_t threads){
+    lept_ndjson s;
+    assert(v != NULL && (json != NULL || len == 0));
+    lept_init(v);
+    s.fn = NULL;
+    s.ctx = NULL;
+    return lept_ndjson_run(&s, v, json, len, threads);
+}
+
+int lept_parse_ndjson_each(const char* json, size_t len, size_t threads, lept_record_handler fn, void* ctx){
+    lept_ndjson s;
+    assert(fn != NULL && (json != NULL || len == 0));
+    s.fn = fn;
+    s.ctx = ctx;
+    s.values = NULL;
+    return lept_ndjson_run(&s, NULL, json, len, threads);
+}
+
+int lept_parse_ndjson_file(const char* path, size_t threads, lept_record_handler fn, void* ctx){
+    const char* data;
+    size_t size;
+    int ret;
+    assert(path != NULL);
+    if ((ret = lept_file_map(path, &data, &size)) != LEPT_PARSE_OK)
+        return ret;
+    ret = lept_parse_ndjson_each(data, size, threads, fn, ctx);
+    lept_file_unmap(data, size);
+    return ret;
+}
+
+/*大文档并行解析部分*/
+//根节点是数组的大文档分两步解析: 先把文本切成每个线程一段, 并行建立结构索引, 找到根数组中每个元素的范围;
+//再把元素分给各个线程, 用各自的lept_parser解析到结果数组中对应的位置
+//结构索引每次处理64字节: 向量比较得到引号, 反斜杠, 括号和逗号的位掩码, 对未转义的引号做前缀异或得到字符串内部的掩码;
+//每段开始时是否在字符串中和开始时的嵌套深度, 由前面各段的引号奇偶性和深度变化的前缀和得到
+//任何不符合预期的结构, 以及元素解析失败, 都退回到lept_parse_n重新解析, 所以结果和错误码与lept_parse_n完全相同
+#ifndef LEPT_PARALLEL_MIN_CHUNK
+#define LEPT_PARALLEL_MIN_CHUNK (1024 * 1024) //每个线程至少分到这么多字节, 更小的文档直接使用lept_parse_n
+#endif
+
+//一块64字节中各类字符的位掩码, 第i位对应第i个字节; '['和'{'都算作open, ']'和'}'都算作close
+typedef struct{
+    uint64_t quote, slash, open, close, comma;
+}lept_block;
+
+static void lept_block_classify(const char* p, lept_block* k){
+#if defined(LEPT_SCAN_AVX2)
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i open  = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    int i;
+    memset(k, 0, sizeof(*k));
+    for (i = 0; i < 64; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        //'['和'{', ']'和'}'只相差0x20这一位
+        __m256i y = _mm256_or_si256(x, lower);
+        k->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, quote)) << i;
+        k->slash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, slash)) << i;
+        k->comma |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, comma)) << i;
+        k->open  |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(y, open)) << i;
+        k->close |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(y, close)) << i;
+    }
+#elif defined(LEPT_SCAN_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open  = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    int i;
+    memset(k, 0, sizeof(*k));
+    for (i = 0; i < 64; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i y = _mm_or_si128(x, lower);
+        k->quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, quote)) << i;
+        k->slash |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, slash)) << i;
+        k->comma |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, comma)) << i;
+        k->open  |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(y, open)) << i;
+        k->close |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(y, close)) << i;
+    }
+#else
+    int i;
+    memset(k, 0, sizeof(*k));
+    for (i = 0; i < 64; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        switch (p[i]) {
+            case '\"': k->quote |= bit; break;
+            case '\\': k->slash |= bit; break;
+            case ',': k->comma |= bit; break;
+            case '[': case '{': k->open |= bit; break;
+            case ']': case '}': k->close |= bit; break;
+        }
+    }
+#endif
+}
+
+//读取从p开始的一块, 不足64字节时用空格补齐
+static void lept_block_load(const char* p, const char* end, lept_block* k){
+    if (end - p >= 64)
+        lept_block_classify(p, k);
+    else {
+        char buf[64];
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf, p, (size_t)(end - p));
+        lept_block_classify(buf, k);
+    }
+}
+
+//由反斜杠的掩码得到被转义的字符的掩码; *carry为1表示上一块的最后一个字符是没有被转义的反斜杠
+//反斜杠只出现在字符串中, 很少连续出现, 所以逐个处理
+static uint64_t lept_block_escaped(uint64_t slash, uint64_t* carry){
+    uint64_t escaped = *carry;
+    *carry = 0;
+    while (slash != 0) {
+        uint64_t bit = slash & (~slash + 1);
+        slash ^= bit;
+        if (!(escaped & bit)) {
+            if (bit >> 63)
+                *carry = 1;
+            else
+                escaped |= bit << 1;
+        }
+    }
+    return escaped;
+}
+
+//前缀异或: 第i位等于x的第0到第i位的异或, 从开始的引号到结束的引号之前都为1
+static uint64_t lept_prefix_xor(uint64_t x){
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static unsigned lept_popcount64(uint64_t x){
+#if defined(__GNUC__)
+    return (unsigned)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//x不为0时最低位的1的位置
+static unsigned lept_first_bit64(uint64_t x){
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    return lept_popcount64((x & (~x + 1)) - 1);
+#endif
+}
+
+typedef struct{
+    const char* json;   //整个文本的开头
+    const char* root;   //根数组的'['
+    const char* begin;  //本段的文本, 除最后一段外长度是64的倍数
+    const char* end;
+    int in_string;      //本段开始时是否在字符串中
+    int parity;         //假设开始时不在字符串中, 本段结束时是否在字符串中
+    long delta[2];      //开始时不在/在字符串中时, 本段中嵌套深度的变化
+    long depth;         //本段开始时的嵌套深度
+    long max_depth;     //本段中达到的最大深度
+    int error;          //出现了根数组之外的结构, 或者深度小于0
+    lept_content pos;   //根数组的'[', 深度为1的','和根数组的']'的偏移, size_t
+}lept_index_chunk;
+
+//本段开头之前连续的反斜杠个数为奇数时, 第一个字符被转义
+static uint64_t lept_index_carry(const lept_index_chunk* k){
+    const char* p;
+    uint64_t carry = 0;
+    for (p = k->begin; p > k->json && p[-1] == '\\'; p--)
+        carry ^= 1;
+    return carry;
+}
+
+//第一遍: 统计本段中引号的奇偶性和两种假设下深度的变化, 只需要计数
+static void lept_index_count(void* arg){
+    lept_index_chunk* k = (lept_index_chunk*)arg;
+    uint64_t carry = lept_index_carry(k), in_string = 0;
+    const char* p;
+    lept_block b;
+    k->delta[0] = k->delta[1] = 0;
+    for (p = k->begin; p < k->end; p += 64) {
+        uint64_t s;
+        lept_block_load(p, k->end, &b);
+        s = lept_prefix_xor(b.quote & ~lept_block_escaped(b.slash, &carry)) ^ in_string;
+        in_string = (uint64_t)0 - (s >> 63);
+        k->delta[0] += (long)lept_popcount64(b.open & ~s) - (long)lept_popcount64(b.close & ~s);
+        k->delta[1] += (long)lept_popcount64(b.open & s) - (long)lept_popcount64(b.close & s);
+    }
+    k->parity = (int)(in_string & 1);
+}
+
+static void lept_index_push(lept_index_chunk* k, const char* p){
+    *(size_t*)lept_content_push(&k->pos, sizeof(size_t)) = (size_t)(p - k->json);
+}
+
+//第二遍: 已知开始时的状态和深度, 记录根数组的边界和元素之间的逗号
+static void lept_index_scan(void* arg){
+    lept_index_chunk* k = (lept_index_chunk*)arg;
+    uint64_t carry = lept_index_carry(k), in_string = k->in_string ? ~(uint64_t)0 : 0;
+    long depth = k->depth;
+    const char* p;
+    lept_block b;
+    k->max_depth = depth;
+    k->error = 0;
+    for (p = k->begin; p < k->end && !k->error; p += 64) {
+        uint64_t s, m;
+        lept_block_load(p, k->end, &b);
+        s = lept_prefix_xor(b.quote & ~lept_block_escaped(b.slash, &carry)) ^ in_string;
+        in_string = (uint64_t)0 - (s >> 63);
+        m = (b.open | b.close | b.comma) & ~s;
+        while (m != 0) {
+            unsigned i = lept_first_bit64(m);
+            uint64_t bit = (uint64_t)1 << i;
+            m ^= bit;
+            if (b.open & bit) {
+                if (depth == 0) {
+                    if (p + i != k->root) {
+                        k->error = 1;
+                        break;
+                    }
+                    lept_index_push(k, p + i);
+                }
+                if (++depth > k->max_depth)
+                    k->max_depth = depth;
+            }
+            else if (b.close & bit) {
+                if (--depth == 0)
+                    lept_index_push(k, p + i);
+                else if (depth < 0) {
+                    k->error = 1;
+                    break;
+                }
+            }
+            else if (depth == 1)
+                lept_index_push(k, p + i);
+            else if (depth == 0) {
+                k->error = 1;
+                break;
+            }
+        }
+    }
+}
+
+typedef struct{
+    const char* json;
+    const size_t* pos;  //第i个元素在pos[i]和pos[i + 1]之间
+    lept_value* values;
+    size_t first, last; //本线程解析的元素序号范围
+    int ret;
+}lept_element_task;
+
+static void lept_element_parse(void* arg){
+    lept_element_task* t = (lept_element_task*)arg;
+    lept_parser p;
+    size_t i;
+    lept_parser_init(&p);
+    t->ret = LEPT_PARSE_OK;
+    for (i = t->first; i < t->last; i++) {
+        t->ret = lept_parser_parse_n(&p, &t->values[i], t->json + t->pos[i] + 1, t->pos[i + 1] - t->pos[i] - 1);
+        if (t->ret != LEPT_PARSE_OK) {
+            lept_free(&t->values[i]);
+            break;
+        }
+    }
+    lept_parser_free(&p);
+}
+
+//并行解析根数组, 失败时返回非LEPT_PARSE_OK, 由调用者退回到lept_parse_n
+static int lept_parse_parallel_array(lept_value* v, const char* json, size_t len, const char* root, size_t n){
+    lept_index_chunk* chunks;
+    lept_element_task* tasks;
+    lept_value* values;
+    size_t *pos, count, size, i, j, top;
+    const char* p;
+    long depth, max_depth;
+    int in_string, ret = LEPT_PARSE_OK;
+
+    chunks = (lept_index_chunk*)LEPT_MALLOC(n * sizeof(lept_index_chunk));
+    size = (len / n + 63) & ~(size_t)63;
+    for (i = 0; i < n; i++) {
+        lept_index_chunk* k = &chunks[i];
+        k->json = json;
+        k->root = root;
+        k->begin = json + (i * size < len ? i * size : len);
+        k->end = i + 1 < n && (i + 1) * size < len ? json + (i + 1) * size : json + len;
+        lept_content_init(&k->pos, NULL, 0);
+    }
+    lept_run_tasks(lept_index_count, chunks, sizeof(lept_index_chunk), n);
+    for (i = 0, in_string = 0, depth = 0; i < n; i++) {
+        chunks[i].in_string = in_string;
+        chunks[i].depth = depth;
+        depth += chunks[i].delta[in_string];
+        in_string ^= chunks[i].parity;
+    }
+    lept_run_tasks(lept_index_scan, chunks, sizeof(lept_index_chunk), n);
+
+    //合并各段的索引
+    for (i = 0, top = 0, max_depth = 0; i < n; i++) {
+        if (chunks[i].error)
+            ret = LEPT_PARSE_INVALID_VALUE;
+        if (chunks[i].max_depth > max_depth)
+            max_depth = chunks[i].max_depth;
+        top += chunks[i].pos.top;
+    }
+    pos = (size_t*)LEPT_MALLOC(top > 0 ? top : 1);
+    for (i = 0, top = 0; i < n; i++) {
+        if (chunks[i].pos.top > 0)
+            memcpy((char*)pos + top, chunks[i].pos.stack, chunks[i].pos.top);
+        top += chunks[i].pos.top;
+        LEPT_FREE(chunks[i].pos.stack);
+    }
+    LEPT_FREE(chunks);
+    count = top / sizeof(size_t);
+    //根数组必须以']'结束, 之后只能有空白
+    if (ret == LEPT_PARSE_OK && (depth != 0 || max_depth > LEPT_PARSE_MAX_DEPTH || count < 2 || json[pos[count - 1]] != ']'))
+        ret = LEPT_PARSE_INVALID_VALUE;
+    for (p = ret == LEPT_PARSE_OK ? json + pos[count - 1] + 1 : json + len; p < json + len; p++)
+        if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+            break;
+        }
+    if (ret != LEPT_PARSE_OK) {
+        LEPT_FREE(pos);
+        return ret;
+    }
+
+    //"[ ]"中只有空白, 是空数组
+    count--;
+    if (count == 1) {
+        for (p = json + pos[0] + 1; *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'; p++)
+            ;
+        if (p == json + pos[1])
+            count = 0;
+    }
+    values = count > 0 ? (lept_value*)LEPT_MALLOC(count * sizeof(lept_value)) : NULL;
+    for (i = 0; i < count; i++)
+        lept_init(&values[i]);
+
+    //按字节数把元素平均分给各个线程
+    tasks = (lept_element_task*)LEPT_MALLOC(n * sizeof(lept_element_task));
+    for (i = 0, j = 0; i < n; i++) {
+        tasks[i].json = json;
+        tasks[i].pos = pos;
+        tasks[i].values = values;
+        tasks[i].first = j;
+        while (j < count && (i + 1 == n || pos[j] < (i + 1) * (len / n)))
+            j++;
+        tasks[i].last = j;
+    }
+    lept_run_tasks(lept_element_parse, tasks, sizeof(lept_element_task), n);
+    for (i = 0; i < n; i++)
+        if (tasks[i].ret != LEPT_PARSE_OK)
+            ret = tasks[i].ret;
+    LEPT_FREE(tasks);
+    LEPT_FREE(pos);
+    if (ret != LEPT_PARSE_OK) {
+        for (i = 0; i < count; i++)
+            lept_free(&values[i]);
+        LEPT_FREE(values);
+        return ret;
+    }
+    v->type = LEPT_ARRAY;
+    v->u.a.e = values;
+    v->u.a.size = count;
+    return LEPT_PARSE_OK;
+}
+
+int lept_parse_parallel(lept_value* v, const char* json, size_t len, size_t threads){
+    const char* root = json;
+    size_t n;
+    assert(v != NULL && (json != NULL || len == 0));
+    if (threads == 0)
+        threads = lept_processor_count();
+    n = len / LEPT_PARALLEL_MIN_CHUNK;
+    if (n > threads)
+        n = threads;
+    while (root < json + len && (*root == ' ' || *root == '\t' || *root == '\n' || *root == '\r'))
+        root++;
+    if (n >= 2 && root < json + len && *root == '[') {
+        lept_init(v);
+        if (lept_parse_parallel_array(v, json, len, root, n) == LEPT_PARSE_OK)
+            return LEPT_PARSE_OK;
+    }
+    return lept_parse_n(v, json, len);
+}
+
+/*键值驻留部分*/
+//池分成若干个分片, 每个分片有自己的锁, 哈希表和存放字符串的arena, 多个线程同时解析时减少锁的争用
+#ifndef LEPT_INTERN_SHARDS
+#define LEPT_INTERN_SHARDS 16
+#endif
+
+typedef struct{
+    const char* s;  //NULL表示空槽
+    size_t len;
+    unsigned hash;
+}lept_intern_entry;
+
+typedef struct{
+    lept_mutex lock;
+    lept_intern_entry* slots;   //开放定址(线性探测)的哈希表
+    size_t cap, size;
+    size_t bytes, limit;        //已经存放的字符串字节数(含'\0')和上限
+    lept_arena strings;
+}lept_intern_shard;
+
+struct lept_intern{
+    lept_intern_shard shards[LEPT_INTERN_SHARDS];
+};
+
+//上限平均分给每个分片, 0表示不限制
+lept_intern* lept_intern_create(size_t limit){
+    lept_intern* t = (lept_intern*)LEPT_MALLOC(sizeof(lept_intern));
+    size_t i;
+    assert(t != NULL);
+    for (i = 0; i < LEPT_INTERN_SHARDS; i++) {
+        lept_intern_shard* sh = &t->shards[i];
+        lept_mutex_init(&sh->lock);
+        sh->slots = NULL;
+        sh->cap = sh->size = 0;
+        sh->bytes = 0;
+        sh->limit = limit ? (limit + LEPT_INTERN_SHARDS - 1) / LEPT_INTERN_SHARDS : (size_t)-1;
+        lept_arena_init(&sh->strings, 0);
+    }
+    return t;
+}
+
+void lept_intern_reset(lept_intern* t){
+    size_t i;
+    assert(t != NULL);
+    for (i = 0; i < LEPT_INTERN_SHARDS; i++) {
+        lept_intern_shard* sh = &t->shards[i];
+        if (sh->size)
+            memset(sh->slots, 0, sh->cap * sizeof(lept_intern_entry));
+        sh->size = sh->bytes = 0;
+        lept_arena_reset(&sh->strings);
+    }
+}
+
+void lept_intern_free(lept_intern* t){
+    size_t i;
+    if (t == NULL)
+        return;
+    for (i = 0; i < LEPT_INTERN_SHARDS; i++) {
+        lept_intern_shard* sh = &t->shards[i];
+        lept_mutex_destroy(&sh->lock);
+        LEPT_FREE(sh->slots);
+        lept_arena_free(&sh->strings);
+    }
+    LEPT_FREE(t);
+}
+
+//装载率超过一半时把哈希表扩大一倍
+static void lept_intern_grow(lept_intern_shard* sh){
+    size_t cap = sh->cap ? sh->cap * 2 : 64, i;
+    lept_intern_entry* slots = (lept_intern_entry*)LEPT_MALLOC(cap * sizeof(lept_intern_entry));
+    assert(slots != NULL);
+    memset(slots, 0, cap * sizeof(lept_intern_entry));
+    for (i = 0; i < sh->cap; i++) {
+        if (sh->slots[i].s != NULL) {
+            size_t h = sh->slots[i].hash & (cap - 1);
+            while (slots[h].s != NULL)
+                h = (h + 1) & (cap - 1);
+            slots[h] = sh->slots[i];
+        }
+    }
+    LEPT_FREE(sh->slots);
+    sh->slots = slots;
+    sh->cap = cap;
+}
+
+const char* lept_intern_n(lept_intern* t, const char* s, size_t len){
+    unsigned hash;
+    lept_intern_shard* sh;
+    lept_intern_entry* e;
+    size_t h;
+    char* str;
+    assert(t != NULL && (s != NULL || len == 0));
+    hash = lept_hash_key(s, len);
+    //分片用哈希的高位, 分片内的哈希表用低位
+    sh = &t->shards[(hash >> 24) % LEPT_INTERN_SHARDS];
+    lept_mutex_lock(&sh->lock);
+    if (sh->size * 2 >= sh->cap)
+        lept_intern_grow(sh);
+    for (h = hash & (sh->cap - 1); (e = &sh->slots[h])->s != NULL; h = (h + 1) & (sh->cap - 1)) {
+        if (e->hash == hash && e->len == len && (len == 0 || memcmp(e->s, s, len) == 0)) {
+            lept_mutex_unlock(&sh->lock);
+            return e->s;
+        }
+    }
+    //池满了之后不再加入新的字符串
+    if (len >= sh->limit - sh->bytes) {
+        lept_mutex_unlock(&sh->lock);
+        return NULL;
+    }
+    sh->bytes += len + 1;
+    str = (char*)lept_arena_alloc(&sh->strings, len + 1);
+    if (len) memcpy(str, s, len);
+    str[len] = '\0';
+    e->s = str;
+    e->len = len;
+    e->hash = hash;
+    sh->size++;
+    lept_mutex_unlock(&sh->lock);
+    return str;
+}
+
+//type
+lept_type lept_get_type(const lept_value* v){
+    assert(v != NULL);
+    return v->type;
+}
+
+//string
+void lept_set_string(lept_value* v, const char* s, size_t len){
+    assert(v != NULL && (s != NULL || len == 0));
+    //释放原来的
+    lept_free(v);
+    //短字符串不需要申请空间
+    if (len <= LEPT_INLINE_MAX) {
+        lept_set_inline_string(v, s, len);
+        return;
+    }
+    //重新申请空间
+    v->u.s.s = (char*)LEPT_MALLOC(len + 1);
+    //拷贝
+    memcpy(v->u.s.s, s, len);
+    v->u.s.s[len] = '\0'; //填补结尾空字符
+    v->u.s.len = len;     //字符串长度
+    v->type = LEPT_STRING;
+}
+
+size_t lept_get_string_length(const lept_value* v){
+    assert(v != NULL && (v->type == LEPT_STRING) );
+    return LEPT_STRING_LEN(v);
+}
+const char* lept_get_string(const lept_value* v){
+    assert(v != NULL && (v->type == LEPT_STRING) );
+    return LEPT_STRING_PTR(v);
+}
+
+//bool类型
 int lept_get_boolean(const lept_value* v){
     assert(v != NULL && (v->type == LEPT_TRUE || v->type == LEPT_FALSE) );
     return v->type == LEPT_TRUE;
@@ -565,152 +3058,1004 @@ void lept_set_number(lept_value* v, double n){
 }
 
 //array获取信息的接口
+//未展开的数组和对象断言失败; 定义NDEBUG时当作空的容器, 返回0或NULL, 不会把文本范围当作元素读取
 lept_value* lept_get_array_element(const lept_value* v, size_t index){
     assert( (v != NULL) && v->type == LEPT_ARRAY);
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return NULL;
     assert( v->u.a.size > index );
     return &v->u.a.e[index];
 }
 size_t lept_get_array_size(const lept_value* v){
     assert( v != NULL && v->type == LEPT_ARRAY);
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return 0;
     return v->u.a.size;
 }
 
 //对象中成员的个数
 size_t lept_get_object_size(const lept_value* v){
     assert(v != NULL && v->type == LEPT_OBJECT );
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return 0;
     return v->u.o.size;
 }
 //对象中成员的键值
 const char* lept_get_object_key(const lept_value* v, size_t index){
     assert(v != NULL && v->type == LEPT_OBJECT);
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return NULL;
     assert( index < v->u.o.size );
     return v->u.o.m[index].key;
 }
 //对象中成员键值的长度
 size_t lept_get_object_key_length(const lept_value* v, size_t index){
     assert(v != NULL && v->type == LEPT_OBJECT );
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return 0;
     assert( index < v->u.o.size );
     return v->u.o.m[index].keyLen;
 }
 //对象成员对应的值
 lept_value* lept_get_object_value(const lept_value* v, size_t index){
     assert(v != NULL && v->type == LEPT_OBJECT);
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return NULL;
     assert( index < v->u.o.size );
     return &v->u.o.m[index].v;
 }
 
+//比较成员的键值, 指针相同时不需要比较内容; interned表示查找的键值来自解析时使用的驻留池,
+//此时驻留的成员键值与它指针不同就一定不相等
+#define LEPT_KEY_EQUAL(m, k, klen, interned) ((m)->keyLen == (klen) && ((m)->key == (k) ||\
+    (!((interned) && ((m)->keyFlags & LEPT_VALUE_INTERNED)) && ((klen) == 0 || memcmp((m)->key, (k), (klen)) == 0))))
 
-#if 1
-// Unoptimized
-static void lept_stringify_string(lept_content* c, const char* s, size_t len) {
+//在已经展开的对象中查找成员, hash为键值的哈希, 只在对象有哈希索引时使用
+static size_t lept_find_member(const lept_value* v, const char* key, size_t klen, unsigned hash, int interned){
     size_t i;
-    assert(s != NULL);
-    PUTC(c, '"');
+    if (v->flags & LEPT_VALUE_INDEXED) {
+        const size_t* slots = LEPT_OBJECT_INDEX(v);
+        size_t mask = lept_index_capacity(v->u.o.size) - 1;
+        size_t h = hash & mask;
+        for (; slots[h] != 0; h = (h + 1) & mask) {
+            const lept_member* m = &v->u.o.m[slots[h] - 1];
+            if (LEPT_KEY_EQUAL(m, key, klen, interned))
+                return slots[h] - 1;
+        }
+        return LEPT_KEY_NOT_EXIST;
+    }
+    for (i = 0; i < v->u.o.size; i++)
+        if (LEPT_KEY_EQUAL(&v->u.o.m[i], key, klen, interned))
+            return i;
+    return LEPT_KEY_NOT_EXIST;
+}
+
+size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen){
+    assert(v != NULL && v->type == LEPT_OBJECT && (key != NULL || klen == 0));
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return LEPT_KEY_NOT_EXIST;
+    return lept_find_member(v, key, klen, (v->flags & LEPT_VALUE_INDEXED) ? lept_hash_key(key, klen) : 0, 0);
+}
+
+lept_value* lept_find_object_value(const lept_value* v, const char* key, size_t klen){
+    size_t index = lept_find_object_index(v, key, klen);
+    return index != LEPT_KEY_NOT_EXIST ? &v->u.o.m[index].v : NULL;
+}
 
+lept_value* lept_find_object_value_interned(const lept_value* v, const char* key, size_t klen){
+    size_t index;
+    assert(v != NULL && v->type == LEPT_OBJECT && (key != NULL || klen == 0));
+    assert(LEPT_EXPANDED(v));
+    if (!LEPT_EXPANDED(v))
+        return NULL;
+    index = lept_find_member(v, key, klen, (v->flags & LEPT_VALUE_INDEXED) ? lept_hash_key(key, klen) : 0, 1);
+    return index != LEPT_KEY_NOT_EXIST ? &v->u.o.m[index].v : NULL;
+}
+
+/*JSON Pointer部分*/
+//编译后的每一段: 解码后的键值, 它的哈希, 以及作为数组索引时的值
+typedef struct{
+    const char* key;
+    size_t len;
+    unsigned hash;
+    size_t index;   //不是有效的数组索引时为LEPT_KEY_NOT_EXIST
+}lept_pointer_token;
+
+//编译结果只占用一块动态空间: 结构体之后依次是各段的lept_pointer_token和解码后的键值
+struct lept_pointer{
+    size_t size;                //段数, 为0时指向根节点
+    lept_pointer_token* tokens;
+};
+
+//数组索引: "0"或者不以0开头的十进制数; 其他的段(包括"-")不指向任何数组元素
+static size_t lept_pointer_index(const char* s, size_t len){
+    size_t i, index = 0;
+    if (len == 0 || len > 19 || (s[0] == '0' && len > 1))
+        return LEPT_KEY_NOT_EXIST;
     for (i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) {
-            case '\"': PUTS(c, "\\\"", 2); break;
-            case '\\': PUTS(c, "\\\\", 2); break;
-            case '\b': PUTS(c, "\\b",  2); break;
-            case '\f': PUTS(c, "\\f",  2); break;
-            case '\n': PUTS(c, "\\n",  2); break;
-            case '\r': PUTS(c, "\\r",  2); break;
-            case '\t': PUTS(c, "\\t",  2); break;
-            default:
-                if (ch < 0x20) {
-                    char buffer[7];
-                    sprintf(buffer, "\\u%04X", ch);
-                    PUTS(c, buffer, 6);
-                }
+        if (s[i] < '0' || s[i] > '9')
+            return LEPT_KEY_NOT_EXIST;
+        index = index * 10 + (size_t)(s[i] - '0');
+    }
+    return index;
+}
+
+lept_pointer* lept_pointer_compile(const char* path){
+    lept_pointer* p;
+    const char* s;
+    char* key;
+    size_t n = 0, len;
+    assert(path != NULL);
+    if (*path != '\0' && *path != '/')
+        return NULL;
+    //检查转义并计算段数, 解码后的键值不会比原文更长
+    for (s = path; *s; s++) {
+        if (*s == '/')
+            n++;
+        else if (*s == '~' && s[1] != '0' && s[1] != '1')
+            return NULL;
+    }
+    len = (size_t)(s - path);
+    p = (lept_pointer*)LEPT_MALLOC(sizeof(lept_pointer) + n * sizeof(lept_pointer_token) + len);
+    assert(p != NULL);
+    p->size = n;
+    p->tokens = (lept_pointer_token*)(p + 1);
+    key = (char*)(p->tokens + n);
+    for (s = path, n = 0; *s; n++) {
+        lept_pointer_token* t = &p->tokens[n];
+        t->key = key;
+        for (s++; *s && *s != '/'; s++) {
+            if (*s == '~')
+                *key++ = *++s == '0' ? '~' : '/';
+            else
+                *key++ = *s;
+        }
+        t->len = (size_t)(key - t->key);
+        t->hash = lept_hash_key(t->key, t->len);
+        t->index = lept_pointer_index(t->key, t->len);
+    }
+    return p;
+}
+
+void lept_pointer_free(lept_pointer* p){
+    LEPT_FREE(p);
+}
+
+lept_value* lept_pointer_get(const lept_value* v, const lept_pointer* p){
+    size_t i, index;
+    assert(v != NULL && p != NULL);
+    for (i = 0; i < p->size; i++) {
+        const lept_pointer_token* t = &p->tokens[i];
+        if (!LEPT_EXPANDED(v))
+            return NULL;
+        if (v->type == LEPT_OBJECT) {
+            if ((index = lept_find_member(v, t->key, t->len, t->hash, 0)) == LEPT_KEY_NOT_EXIST)
+                return NULL;
+            v = &v->u.o.m[index].v;
+        }
+        else if (v->type == LEPT_ARRAY) {
+            if (t->index == LEPT_KEY_NOT_EXIST || t->index >= v->u.a.size)
+                return NULL;
+            v = &v->u.a.e[t->index];
+        }
+        else
+            return NULL;
+    }
+    return (lept_value*)v;
+}
+
+//跳过一个值, 数组和对象只检查括号是否配对, 不申请动态空间
+static int lept_pointer_skip_value(lept_content* c){
+    lept_value e;
+    char* str;
+    size_t len;
+    switch (PEEK(c)) {
+        case '[':
+        case '{': return lept_skip_container(c, &e);
+        case '"': return lept_parse_string_raw(c, &str, &len);
+        default:  return lept_parse_scalar(c, &e); //只剩下字面量和数字, 不会申请空间
+    }
+}
+
+//在文本中找到第t段指向的值, c->json移动到这个值的开头
+static int lept_pointer_find(lept_content* c, const lept_pointer_token* t){
+    char* str;
+    size_t len, i;
+    int ret;
+    if (PEEK(c) == '{') {
+        c->json++;
+        lept_parse_whiteSpace(c);
+        if (PEEK(c) == '}')
+            return LEPT_PARSE_NOT_FOUND;
+        while (1) {
+            if (PEEK(c) != '"')
+                return LEPT_PARSE_MISS_KEY;
+            if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+                return ret;
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) != ':')
+                return LEPT_PARSE_MISS_COLON;
+            c->json++;
+            lept_parse_whiteSpace(c);
+            if (len == t->len && (len == 0 || memcmp(str, t->key, len) == 0))
+                return LEPT_PARSE_OK;
+            if ((ret = lept_pointer_skip_value(c)) != LEPT_PARSE_OK)
+                return ret;
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) == '}')
+                return LEPT_PARSE_NOT_FOUND;
+            if (PEEK(c) != ',')
+                return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            c->json++;
+            lept_parse_whiteSpace(c);
+        }
+    }
+    if (PEEK(c) == '[') {
+        c->json++;
+        lept_parse_whiteSpace(c);
+        if (PEEK(c) == ']' || t->index == LEPT_KEY_NOT_EXIST)
+            return LEPT_PARSE_NOT_FOUND;
+        for (i = 0; i < t->index; i++) {
+            if ((ret = lept_pointer_skip_value(c)) != LEPT_PARSE_OK)
+                return ret;
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) == ']')
+                return LEPT_PARSE_NOT_FOUND;
+            if (PEEK(c) != ',')
+                return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            c->json++;
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) == ']')
+                return LEPT_PARSE_MISS_ARRAY_ELEMENT;
+        }
+        return LEPT_PARSE_OK;
+    }
+    //标量中不存在下一段
+    return PEEK(c) == '\0' && c->json == c->end ? LEPT_PARSE_EXCEPT_VALUE : LEPT_PARSE_NOT_FOUND;
+}
+
+//从c->json处的值开始依次查找p的第first段及之后的各段, 找到后解析指向的值
+static int lept_pointer_resolve(lept_content* c, const lept_pointer* p, size_t first, lept_value* v){
+    int ret = LEPT_PARSE_OK;
+    for (; first < p->size && ret == LEPT_PARSE_OK; first++)
+        ret = lept_pointer_find(c, &p->tokens[first]);
+    //找到之后只解析这个值, 不再读取它之后的文本
+    if (ret == LEPT_PARSE_OK)
+        ret = lept_parse_value(c, v);
+    return ret;
+}
+
+int lept_pointer_parse(lept_value* v, const char* json, size_t len, const lept_pointer* p){
+    lept_content c;
+    int ret;
+    assert(v != NULL && p != NULL && (json != NULL || len == 0));
+    lept_content_init(&c, json, len);
+    lept_init(v);
+    lept_parse_whiteSpace(&c);
+    ret = lept_pointer_resolve(&c, p, 0, v);
+    assert(c.top == 0);
+    LEPT_FREE(c.stack);
+    return ret;
+}
+
+
+/*选择性解析部分*/
+//一次扫描同时查找多个路径: matched[i]记录第i个路径与当前位置的前多少段相同, 等于当前位置的深度时, 路径指向的值可能在当前值之中;
+//没有路径经过的值直接跳过, 只有路径指向的值才会解析为节点
+#define LEPT_SELECT_DONE ((size_t)-1) //路径已经找到, 或者已经确定不存在
+
+//路径上一层尚未结束的数组或对象
+typedef struct{
+    lept_type type;
+    size_t index;   //当前元素的索引, 只用于数组
+}lept_select_frame;
+
+//结束深度为depth的容器中的一个子节点: 经过这个子节点的路径没有在其中找到指向的值, 就确定不存在;
+//与lept_find_object_value一样, 重复的键值只查找第一个成员
+static void lept_select_leave(size_t* matched, size_t n, size_t depth, size_t* remaining){
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (matched[i] != LEPT_SELECT_DONE && matched[i] > depth) {
+            matched[i] = LEPT_SELECT_DONE;
+            (*remaining)--;
+        }
+    }
+}
+
+//进入深度为depth的容器中的下一个子节点: 数组的第index个元素, 或者键值为key的成员
+static void lept_select_enter(const lept_pointer* const* paths, size_t* matched, size_t n, size_t* remaining, size_t depth,
+    lept_type type, const char* key, size_t klen, size_t index){
+    size_t i;
+    lept_select_leave(matched, n, depth, remaining);
+    for (i = 0; i < n; i++) {
+        const lept_pointer_token* t;
+        if (matched[i] != depth || paths[i]->size <= depth)
+            continue;
+        t = &paths[i]->tokens[depth];
+        if (type == LEPT_ARRAY ? t->index == index : (t->len == klen && (klen == 0 || memcmp(t->key, key, klen) == 0)))
+            matched[i] = depth + 1;
+    }
+}
+
+//解析对象成员的键值和冒号, 并进入这个成员
+static int lept_select_key(lept_content* c, const lept_pointer* const* paths, size_t* matched, size_t n, size_t* remaining, size_t depth){
+    char* str;
+    size_t len;
+    int ret;
+    if (PEEK(c) != '"')
+        return LEPT_PARSE_MISS_KEY;
+    if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+        return ret;
+    lept_parse_whiteSpace(c);
+    if (PEEK(c) != ':')
+        return LEPT_PARSE_MISS_COLON;
+    c->json++;
+    lept_parse_whiteSpace(c);
+    lept_select_enter(paths, matched, n, remaining, depth, LEPT_OBJECT, str, len, 0);
+    return LEPT_PARSE_OK;
+}
+
+//当前值是一个或多个路径指向的值: 解析第一个路径指向的值, 指向其中更深位置的路径从这个值的开头重新查找
+static int lept_select_target(lept_content* c, const lept_pointer* const* paths, size_t* matched, size_t n, size_t depth,
+    lept_value* values, size_t* remaining){
+    const char* start = c->json;
+    size_t i, first = n;
+    int ret;
+    for (i = 0; i < n && first == n; i++)
+        if (matched[i] == depth && paths[i]->size == depth)
+            first = i;
+    if ((ret = lept_parse_value(c, &values[first])) != LEPT_PARSE_OK)
+        return ret;
+    matched[first] = LEPT_SELECT_DONE;
+    (*remaining)--;
+    for (i = 0; i < n; i++) {
+        if (matched[i] == depth) {
+            lept_content sub = *c;
+            sub.json = start;
+            //没有找到时values[i]保持原样, 仍然带有LEPT_VALUE_MISSING
+            lept_pointer_resolve(&sub, paths[i], depth, &values[i]);
+            c->stack = sub.stack;
+            c->size = sub.size;
+            matched[i] = LEPT_SELECT_DONE;
+            (*remaining)--;
+        }
+    }
+    return LEPT_PARSE_OK;
+}
+
+static int lept_select_value(lept_content* c, const lept_pointer* const* paths, size_t n, lept_value* values, int flags,
+    size_t* matched, lept_select_frame* frames){
+    lept_handler validator; //所有回调都为NULL, 只校验语法
+    size_t i, depth = 0, remaining = n;
+    int ret;
+    memset(&validator, 0, sizeof(validator));
+    while (1) {
+        /* 当前值: 是路径指向的值, 需要进入其中, 或者跳过 */
+        int target = 0, inside = 0;
+        for (i = 0; i < n; i++) {
+            if (matched[i] == depth) {
+                if (paths[i]->size == depth)
+                    target = 1;
                 else
-                    PUTC(c, s[i]);
+                    inside = 1;
+            }
+        }
+        if (target) {
+            if ((ret = lept_select_target(c, paths, matched, n, depth, values, &remaining)) != LEPT_PARSE_OK)
+                return ret;
+        }
+        else if (inside && (PEEK(c) == '[' || PEEK(c) == '{')) {
+            lept_select_frame* f = &frames[depth++];
+            f->type = *c->json == '[' ? LEPT_ARRAY : LEPT_OBJECT;
+            f->index = 0;
+            c->json++;
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) == (f->type == LEPT_ARRAY ? ']' : '}')) {
+                c->json++;
+                depth--;
+            }
+            else {
+                if (f->type == LEPT_ARRAY)
+                    lept_select_enter(paths, matched, n, &remaining, depth - 1, LEPT_ARRAY, NULL, 0, 0);
+                else if ((ret = lept_select_key(c, paths, matched, n, &remaining, depth - 1)) != LEPT_PARSE_OK)
+                    return ret;
+                continue;
+            }
+        }
+        else if ((ret = (flags & LEPT_SELECT_VALIDATE) ? lept_sax_parse_value(c, &validator, NULL) : lept_pointer_skip_value(c)) != LEPT_PARSE_OK)
+            return ret;
+
+        /* 一个值结束之后: 全部找到时提前结束, 否则继续下一个元素或成员 */
+        if (remaining == 0 && !(flags & LEPT_SELECT_VALIDATE))
+            return LEPT_PARSE_OK;
+        while (1) {
+            lept_select_frame* f;
+            if (depth == 0) {
+                lept_parse_whiteSpace(c);
+                return c->json == c->end ? LEPT_PARSE_OK : LEPT_PARSE_ROOT_NOT_SINGULAR;
+            }
+            f = &frames[depth - 1];
+            lept_parse_whiteSpace(c);
+            if (PEEK(c) == ',') {
+                c->json++;
+                lept_parse_whiteSpace(c);
+                if (f->type == LEPT_ARRAY) {
+                    if (PEEK(c) == ']')
+                        return LEPT_PARSE_MISS_ARRAY_ELEMENT;
+                    lept_select_enter(paths, matched, n, &remaining, depth - 1, LEPT_ARRAY, NULL, 0, ++f->index);
+                }
+                else if ((ret = lept_select_key(c, paths, matched, n, &remaining, depth - 1)) != LEPT_PARSE_OK)
+                    return ret;
+                break;
+            }
+            else if (PEEK(c) == (f->type == LEPT_ARRAY ? ']' : '}')) {
+                c->json++;
+                lept_select_leave(matched, n, --depth, &remaining);
+                if (remaining == 0 && !(flags & LEPT_SELECT_VALIDATE))
+                    return LEPT_PARSE_OK;
+            }
+            else
+                return f->type == LEPT_ARRAY ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
         }
     }
-    PUTC(c, '"');
 }
-#else
+
+int lept_parse_select(const char* json, size_t len, const lept_pointer* const* paths, size_t n, lept_value* values, int flags){
+    lept_content c;
+    lept_select_frame* frames = NULL;
+    size_t* matched;
+    size_t i, max_depth = 0;
+    int ret;
+    assert((json != NULL || len == 0) && (paths != NULL || n == 0) && (values != NULL || n == 0));
+    //只会沿着路径进入数组和对象, 层数不超过最长的路径; 路径的状态和每层的记录一次申请
+    for (i = 0; i < n; i++)
+        if (paths[i]->size > max_depth)
+            max_depth = paths[i]->size;
+    if (n > 0) {
+        frames = (lept_select_frame*)LEPT_MALLOC(max_depth * sizeof(lept_select_frame) + n * sizeof(size_t));
+        assert(frames != NULL);
+    }
+    matched = n > 0 ? (size_t*)(frames + max_depth) : NULL;
+    for (i = 0; i < n; i++) {
+        lept_init(&values[i]);
+        values[i].flags = LEPT_VALUE_MISSING;
+        matched[i] = 0;
+    }
+    lept_content_init(&c, json, len);
+    lept_parse_whiteSpace(&c);
+    ret = lept_select_value(&c, paths, n, values, flags, matched, frames);
+    if (ret != LEPT_PARSE_OK) {
+        for (i = 0; i < n; i++)
+            lept_free(&values[i]);
+    }
+    else {
+        for (i = 0; i < n; i++)
+            if (values[i].flags & LEPT_VALUE_MISSING)
+                ret = LEPT_PARSE_NOT_FOUND;
+    }
+    LEPT_FREE(frames);
+    LEPT_FREE(c.stack);
+    return ret;
+}
+
+
+/*number生成部分*/
+//生成能够还原为原double的最短的十进制数字, 有多个时取最接近的, 避免sprintf("%.17g")输出多余的数字;
+//先用Grisu3算法, 它能判断自己的结果是否正确, 不能确定时(约0.5%)再用大整数精确计算
+//Grisu中使用的浮点数 f * 2^e, f为64位的有效数字
+typedef struct { uint64_t f; int e; } lept_diyfp;
+
+#define LEPT_DP_SIGNIFICAND_MASK ((((uint64_t)1) << 52) - 1)
+#define LEPT_DP_HIDDEN_BIT       (((uint64_t)1) << 52)
+#define LEPT_DP_EXPONENT_BIAS    (0x3FF + 52)
+
+static lept_diyfp lept_diyfp_make(uint64_t f, int e){
+    lept_diyfp r;
+    r.f = f;
+    r.e = e;
+    return r;
+}
+
+//两个diyfp相乘, 保留乘积的高64位并四舍五入
+static lept_diyfp lept_diyfp_mul(lept_diyfp x, lept_diyfp y){
+    lept_uint128 p = lept_mul64(x.f, y.f);
+    return lept_diyfp_make(p.hi + (p.lo >> 63), x.e + y.e + 64);
+}
+
+static lept_diyfp lept_diyfp_normalize(lept_diyfp x){
+    int s = lept_leading_zeros(x.f);
+    return lept_diyfp_make(x.f << s, x.e - s);
+}
+
+//10^k的64位近似值, k从-348到340, 步长为8
+static const uint64_t lept_cached_powers_f[] = {
+        0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+        0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+        0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+        0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+        0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+        0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+        0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+        0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+        0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+        0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+        0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+        0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+        0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+        0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+        0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+        0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+        0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+        0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+        0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+        0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+        0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+        0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+static const short lept_cached_powers_e[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,
+         -954,  -927,  -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,
+         -688,  -661,  -635,  -608,  -582,  -555,  -529,  -502,  -475,  -449,
+         -422,  -396,  -369,  -343,  -316,  -289,  -263,  -236,  -210,  -183,
+         -157,  -130,  -103,   -77,   -50,   -24,     3,    30,    56,    83,
+          109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+          375,   402,   428,   455,   481,   508,   534,   561,   588,   614,
+          641,   667,   694,   720,   747,   774,   800,   827,   853,   880,
+          907,   933,   960,   986,  1013,  1039,  1066
+};
+
+//选取10^-K使得 w * 10^-K 的二进制指数落在[-60, -32]之间
+static lept_diyfp lept_cached_power(int e, int* K){
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    unsigned index;
+    if (dk - k > 0.0)
+        k++;
+    index = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    return lept_diyfp_make(lept_cached_powers_f[index], lept_cached_powers_e[index]);
+}
+
+static const uint64_t lept_pow10_u64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+//Grisu3: 把最后一位逐步减小到最接近w的位置, 再检查在误差范围内结果是否一定是最短且最接近的;
+//rest为数字串与too_high的距离, unit为误差的单位
+static int lept_grisu_weed(char* buffer, int len, uint64_t distance_too_high_w, uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa, uint64_t unit){
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance || small_distance - rest >= rest + ten_kappa - small_distance)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+    //在误差范围内, 减小后的数字也可能更接近真实值
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance || big_distance - rest > rest + ten_kappa - big_distance))
+        return 0;
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+//在(low, high)向外扩大一个误差单位的区间内生成最短的数字串; 不能确定结果正确时返回0
+static int lept_grisu_digit_gen(lept_diyfp low, lept_diyfp W, lept_diyfp high, char* buffer, int* len, int* K){
+    const lept_diyfp one = lept_diyfp_make((uint64_t)1 << -W.e, W.e);
+    uint64_t unit = 1;
+    const uint64_t too_high = high.f + unit;
+    uint64_t unsafe_interval = too_high - (low.f - unit);
+    uint32_t p1 = (uint32_t)(too_high >> -one.e);
+    uint64_t p2 = too_high & (one.f - 1);
+    int kappa = 1;
+    while (kappa < 10 && p1 >= lept_pow10_u64[kappa])
+        kappa++;
+    *len = 0;
+
+    //整数部分
+    while (kappa > 0) {
+        uint32_t d = (uint32_t)(p1 / lept_pow10_u64[kappa - 1]);
+        uint64_t rest;
+        p1 %= (uint32_t)lept_pow10_u64[kappa - 1];
+        buffer[(*len)++] = (char)('0' + d);
+        kappa--;
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest < unsafe_interval) {
+            *K += kappa;
+            return lept_grisu_weed(buffer, *len, too_high - W.f, unsafe_interval, rest, lept_pow10_u64[kappa] << -one.e, unit);
+        }
+    }
+
+    //小数部分
+    for (;;) {
+        p2 *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buffer[(*len)++] = (char)('0' + (p2 >> -one.e));
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < unsafe_interval) {
+            *K += kappa;
+            return lept_grisu_weed(buffer, *len, (too_high - W.f) * unit, unsafe_interval, p2, one.f, unit);
+        }
+    }
+}
+
+//value为有限的正数, 生成最短的数字串buffer, 数值为 buffer * 10^K; 误差使结果无法确定时返回0
+static int lept_grisu3(double value, char* buffer, int* len, int* K){
+    uint64_t bits, significand;
+    int biased_e;
+    lept_diyfp v, w_m, w_p, c_mk, W, Wp, Wm;
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits >> 52) & 0x7FF);
+    significand = bits & LEPT_DP_SIGNIFICAND_MASK;
+    if (biased_e != 0)
+        v = lept_diyfp_make(significand + LEPT_DP_HIDDEN_BIT, biased_e - LEPT_DP_EXPONENT_BIAS);
+    else
+        v = lept_diyfp_make(significand, 1 - LEPT_DP_EXPONENT_BIAS);
+
+    //相邻double的中点作为边界 m+ 和 m-; 2的整数次幂(最小的规格化数除外)与前一个double的间距只有一半
+    w_p = lept_diyfp_make((v.f << 1) + 1, v.e - 1);
+    while (!(w_p.f & (LEPT_DP_HIDDEN_BIT << 1))) {
+        w_p.f <<= 1;
+        w_p.e--;
+    }
+    w_p.f <<= 64 - 52 - 2;
+    w_p.e -= 64 - 52 - 2;
+    w_m = (significand == 0 && biased_e > 1) ? lept_diyfp_make((v.f << 2) - 1, v.e - 2) : lept_diyfp_make((v.f << 1) - 1, v.e - 1);
+    w_m.f <<= w_m.e - w_p.e;
+    w_m.e = w_p.e;
+
+    c_mk = lept_cached_power(w_p.e, K);
+    W = lept_diyfp_mul(lept_diyfp_normalize(v), c_mk);
+    Wp = lept_diyfp_mul(w_p, c_mk);
+    Wm = lept_diyfp_mul(w_m, c_mk);
+    return lept_grisu_digit_gen(Wm, W, Wp, buffer, len, K);
+}
+
+//Grisu3无法确定时, 用大整数精确地生成最短且最接近的数字串(Steele & White的算法), 结果的含义同lept_grisu3;
+//r / s为当前的余数, mp / s和mm / s为到上下两个中点的距离
+static void lept_dtoa_bignum(double value, char* buffer, int* len, int* K){
+    lept_bignum r, s, mp, mm, t;
+    uint64_t bits, f;
+    int biased_e, e, k, even, c;
+    double est;
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits >> 52) & 0x7FF);
+    f = bits & LEPT_DP_SIGNIFICAND_MASK;
+    if (biased_e != 0) {
+        f += LEPT_DP_HIDDEN_BIT;
+        e = biased_e - LEPT_DP_EXPONENT_BIAS;
+    }
+    else
+        e = 1 - LEPT_DP_EXPONENT_BIAS;
+    //尾数为偶数时, 中点按就近舍入到偶数还原为value, 边界也包含在区间内
+    even = !(f & 1);
+    lept_bignum_set_u64(&r, f << 1);
+    lept_bignum_set_u64(&s, 2);
+    lept_bignum_set_u64(&mp, 1);
+    lept_bignum_set_u64(&mm, 1);
+    if (e >= 0) {
+        lept_bignum_shl(&r, e);
+        lept_bignum_shl(&mp, e);
+        lept_bignum_shl(&mm, e);
+    }
+    else
+        lept_bignum_shl(&s, -e);
+    if (f == LEPT_DP_HIDDEN_BIT && biased_e > 1) {
+        lept_bignum_shl(&r, 1);
+        lept_bignum_shl(&s, 1);
+        lept_bignum_shl(&mp, 1);
+    }
+
+    //乘上10^-k使得上边界落在[0.1, 1)中, k先由二进制指数估计, 再逐位修正
+    est = (e + 63 - lept_leading_zeros(f)) * 0.30102999566398114;
+    k = (int)est;
+    if (est - k > 0.0)
+        k++;
+    if (k >= 0) {
+        lept_bignum_pow5(&s, k);
+        lept_bignum_shl(&s, k);
+    }
+    else {
+        lept_bignum_pow5(&r, -k);
+        lept_bignum_shl(&r, -k);
+        lept_bignum_pow5(&mp, -k);
+        lept_bignum_shl(&mp, -k);
+        lept_bignum_pow5(&mm, -k);
+        lept_bignum_shl(&mm, -k);
+    }
+    for (;;) {
+        lept_bignum_add(&t, &r, &mp);
+        c = lept_bignum_cmp(&t, &s);
+        if (!(even ? c >= 0 : c > 0))
+            break;
+        lept_bignum_mul_add(&s, 10, 0);
+        k++;
+    }
+    for (;;) {
+        lept_bignum_add(&t, &r, &mp);
+        lept_bignum_mul_add(&t, 10, 0);
+        c = lept_bignum_cmp(&t, &s);
+        if (!(even ? c < 0 : c <= 0))
+            break;
+        lept_bignum_mul_add(&r, 10, 0);
+        lept_bignum_mul_add(&mp, 10, 0);
+        lept_bignum_mul_add(&mm, 10, 0);
+        k--;
+    }
+
+    //逐位生成, 直到去掉后面的数字(low)或者进位(high)之后仍在区间内
+    *len = 0;
+    for (;;) {
+        int d = 0, low, high;
+        lept_bignum_mul_add(&r, 10, 0);
+        lept_bignum_mul_add(&mp, 10, 0);
+        lept_bignum_mul_add(&mm, 10, 0);
+        while (lept_bignum_cmp(&r, &s) >= 0) {
+            lept_bignum_sub(&r, &s);
+            d++;
+        }
+        c = lept_bignum_cmp(&r, &mm);
+        low = even ? c <= 0 : c < 0;
+        lept_bignum_add(&t, &r, &mp);
+        c = lept_bignum_cmp(&t, &s);
+        high = even ? c >= 0 : c > 0;
+        if (!low && !high) {
+            buffer[(*len)++] = (char)('0' + d);
+            continue;
+        }
+        //两者都可以时选择离value更近的, 一样近时选择偶数
+        if (low && high) {
+            lept_bignum_add(&t, &r, &r);
+            c = lept_bignum_cmp(&t, &s);
+            if (c > 0 || (c == 0 && (d & 1)))
+                d++;
+        }
+        else if (high)
+            d++;
+        buffer[(*len)++] = (char)('0' + d);
+        break;
+    }
+    *K = k - *len;
+}
+
+//把无符号整数写入buffer, 返回写入的字符数
+static int lept_write_u64(char* buffer, uint64_t u){
+    char tmp[20];
+    int n = 0, i;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    for (i = 0; i < n; i++)
+        buffer[i] = tmp[n - 1 - i];
+    return n;
+}
+
+//把double格式化为json数字, 返回写入的字符数(最多25个字符);
+//输出格式和"%.17g"一致: 十进制指数在[-4, 17)之间时使用定点表示, 否则使用科学计数法, 如1e+20
+static int lept_format_double(char* buffer, double d){
+    char digits[20];
+    char* p = buffer;
+    int len, K, kk, i;
+    if (d != d || d == HUGE_VAL || d == -HUGE_VAL)
+        return sprintf(buffer, "%.17g", d);
+    if (d < 0 || (d == 0 && 1.0 / d < 0)) {
+        *p++ = '-';
+        d = -d;
+    }
+    //整数的快速路径, 2^53以内的整数都可以精确表示
+    if (d < 9007199254740992.0 && d == (double)(uint64_t)d)
+        return (int)(p - buffer) + lept_write_u64(p, (uint64_t)d);
+
+    if (!lept_grisu3(d, digits, &len, &K))
+        lept_dtoa_bignum(d, digits, &len, &K);
+    kk = len + K; //小数点前的数字个数, 数值为 0.digits * 10^kk
+    if (kk >= -3 && kk <= 17) {
+        if (kk <= 0) {
+            //0.00ddd
+            *p++ = '0';
+            *p++ = '.';
+            for (i = kk; i < 0; i++)
+                *p++ = '0';
+            memcpy(p, digits, len);
+            p += len;
+        }
+        else if (kk < len) {
+            //dd.ddd
+            memcpy(p, digits, kk);
+            p += kk;
+            *p++ = '.';
+            memcpy(p, digits + kk, len - kk);
+            p += len - kk;
+        }
+        else {
+            //ddd00
+            memcpy(p, digits, len);
+            p += len;
+            for (i = len; i < kk; i++)
+                *p++ = '0';
+        }
+    }
+    else {
+        //d.ddde+XX, 指数至少两位
+        int exp10 = kk - 1;
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        if (exp10 < 0) {
+            *p++ = '-';
+            exp10 = -exp10;
+        }
+        else
+            *p++ = '+';
+        if (exp10 < 10)
+            *p++ = '0';
+        p += lept_write_u64(p, (uint64_t)exp10);
+    }
+    return (int)(p - buffer);
+}
+
+
+//输出字符串: 用lept_scan_string找出不需要转义的连续字节整段拷贝, 只对'"', '\\'和控制字符逐个转义;
 //自行编写十六进位输出，避免了 `printf()` 内解析格式的开销
 static void lept_stringify_string(lept_content* c, const char* s, size_t len) {
     static const char hex_digits[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-    size_t i, size;
-    char* head, *p;
-    assert(s != NULL);
-    p = head = lept_content_push(c, size = len * 6 + 2); /* "\u00xx..." */
-    *p++ = '"';
-    for (i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) {
-            case '\"': *p++ = '\\'; *p++ = '\"'; break;
-            case '\\': *p++ = '\\'; *p++ = '\\'; break;
-            case '\b': *p++ = '\\'; *p++ = 'b';  break;
-            case '\f': *p++ = '\\'; *p++ = 'f';  break;
-            case '\n': *p++ = '\\'; *p++ = 'n';  break;
-            case '\r': *p++ = '\\'; *p++ = 'r';  break;
-            case '\t': *p++ = '\\'; *p++ = 't';  break;
-            default:
-                if (ch < 0x20) {
-                    *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
-                    *p++ = hex_digits[ch >> 4];
-                    *p++ = hex_digits[ch & 15];
-                }
-                else
-                    *p++ = s[i];
+    const char* end = s + len;
+    assert(s != NULL || len == 0);
+    PUTC(c, '"');
+    while (s < end) {
+        const char* q = lept_scan_string(s, end);
+        if (q != s) {
+            lept_content_write(c, s, (size_t)(q - s));
+            s = q;
+        }
+        //连续的需要转义的字符依次处理, 不再重新扫描
+        while (s < end && LEPT_STRING_SPECIAL(*s)) {
+            unsigned char ch = (unsigned char)*s++;
+            char* p = lept_content_push(c, 6); /* "\u00xx" */
+            p[0] = '\\';
+            switch (ch) {
+                case '\"': p[1] = '\"'; break;
+                case '\\': p[1] = '\\'; break;
+                case '\b': p[1] = 'b';  break;
+                case '\f': p[1] = 'f';  break;
+                case '\n': p[1] = 'n';  break;
+                case '\r': p[1] = 'r';  break;
+                case '\t': p[1] = 't';  break;
+                default:
+                    p[1] = 'u'; p[2] = '0'; p[3] = '0';
+                    p[4] = hex_digits[ch >> 4];
+                    p[5] = hex_digits[ch & 15];
+                    continue;
+            }
+            c->top -= 4;
         }
     }
-    *p++ = '"';
-    c->top -= size - (p - head);
+    PUTC(c, '"');
 }
-#endif
 
-static void lept_stringify_value(lept_content* c, const lept_value* v) {
-    size_t i;
-    switch (v->type) {
-        case LEPT_NULL:   PUTS(c, "null",  4); break;
-        case LEPT_FALSE:  PUTS(c, "false", 5); break;
-        case LEPT_TRUE:   PUTS(c, "true",  4); break;
-        //将浮点数转换为文本字符串;
-        case LEPT_NUMBER: 
-            //"%.17g"足够把双精度浮点数转换为可还原的文本;
-            c->top -= 32 - sprintf(lept_content_push(c, 32), "%.17g", v->u.n);
-            break;
-        //转换string字符串
-        case LEPT_STRING: 
-            lept_stringify_string(c, v->u.s.s, v->u.s.len); 
+//遍历到一半的数组或对象: 已经输出到第index个元素或成员
+typedef struct {
+    const lept_value* v;
+    size_t index;
+} lept_stringify_frame;
+
+//不使用递归: 尚未输出完的数组和对象记录在另一个lept_content中, 调用栈的深度与嵌套深度无关
+//尚未展开的数组和对象临时完整解析之后输出, 不修改节点; 其中有语法错误时返回LEPT_STRINGIFY_PARSE_ERROR
+static int lept_stringify_value(lept_content* c, const lept_value* v) {
+    lept_content work;
+    int ret = LEPT_STRINGIFY_OK;
+    lept_content_init(&work, NULL, 0);
+    while (v != NULL) {
+        size_t size;
+        /* 输出一个值; 非空的数组和对象只输出开头, 然后进入它的第一个元素或成员 */
+        switch (v->type) {
+            case LEPT_NULL:   PUTS(c, "null",  4); break;
+            case LEPT_FALSE:  PUTS(c, "false", 5); break;
+            case LEPT_TRUE:   PUTS(c, "true",  4); break;
+            //将浮点数转换为文本字符串;
+            case LEPT_NUMBER: 
+                //生成可还原的最短文本;
+                c->top -= 32 - lept_format_double(lept_content_push(c, 32), v->u.n);
+                break;
+            //转换string字符串
+            case LEPT_STRING: 
+                lept_stringify_string(c, LEPT_STRING_PTR(v), LEPT_STRING_LEN(v));
+                break;
+            case LEPT_ARRAY:
+            case LEPT_OBJECT:
+                if (!LEPT_EXPANDED(v)) {
+                    //临时解析的节点中没有惰性的容器, 递归只有一层
+                    lept_value e;
+                    if (lept_parse_json(&e, v->u.l.json, v->u.l.len, NULL, 0, 0) != LEPT_PARSE_OK)
+                        ret = LEPT_STRINGIFY_PARSE_ERROR;
+                    else {
+                        ret = lept_stringify_value(c, &e);
+                        lept_free(&e);
+                    }
+                    break;
+                }
+                PUTC(c, v->type == LEPT_ARRAY ? '[' : '{');
+                size = v->type == LEPT_ARRAY ? v->u.a.size : v->u.o.size;
+                if (size > 0) {
+                    lept_stringify_frame* f = (lept_stringify_frame*)lept_content_push(&work, sizeof(lept_stringify_frame));
+                    f->v = v;
+                    f->index = 0;
+                    if (v->type == LEPT_ARRAY)
+                        v = &v->u.a.e[0];
+                    else {
+                        lept_stringify_string(c, v->u.o.m[0].key, v->u.o.m[0].keyLen);
+                        PUTC(c, ':');
+                        v = &v->u.o.m[0].v;
+                    }
+                    continue;
+                }
+                PUTC(c, v->type == LEPT_ARRAY ? ']' : '}');
+                break;
+            default: assert(0 && "invalid type");
+        }
+        if (ret != LEPT_STRINGIFY_OK)
             break;
-        case LEPT_ARRAY:
-            PUTC(c, '[');
-            for (i = 0; i < v->u.a.size; i++) {
-                if (i > 0)
+
+        /* 一个值输出完毕: 输出所在容器的下一个元素或成员, 或者结束这个容器; 全部结束时v为NULL */
+        v = NULL;
+        while (work.top > 0) {
+            lept_stringify_frame* f = (lept_stringify_frame*)(work.stack + work.top - sizeof(lept_stringify_frame));
+            const lept_value* parent = f->v;
+            size_t i = ++f->index;
+            if (parent->type == LEPT_ARRAY) {
+                if (i < parent->u.a.size) {
                     PUTC(c, ',');
-                lept_stringify_value(c, &v->u.a.e[i]);
+                    v = &parent->u.a.e[i];
+                    break;
+                }
+                PUTC(c, ']');
             }
-            PUTC(c, ']');
-            break;
-        case LEPT_OBJECT:
-            PUTC(c, '{');
-            for (i = 0; i < v->u.o.size; i++) {
-                if (i > 0)
+            else {
+                if (i < parent->u.o.size) {
                     PUTC(c, ',');
-                lept_stringify_string(c, v->u.o.m[i].key, v->u.o.m[i].keyLen);
-                PUTC(c, ':');
-                lept_stringify_value(c, &v->u.o.m[i].v);
+                    lept_stringify_string(c, parent->u.o.m[i].key, parent->u.o.m[i].keyLen);
+                    PUTC(c, ':');
+                    v = &parent->u.o.m[i].v;
+                    break;
+                }
+                PUTC(c, '}');
             }
-            PUTC(c, '}');
-            break;
-        default: assert(0 && "invalid type");
+            lept_content_pop(&work, sizeof(lept_stringify_frame));
+        }
     }
+    LEPT_FREE(work.stack);
+    return ret;
 }
 
 char* lept_stringify(const lept_value* v, size_t* length) {
     lept_content c;
     assert(v != NULL);
     //申请输出缓冲区
-    c.stack = (char*)malloc(c.size = LEPT_PARSE_STRINGIFY_INIT_SIZE);
+    lept_content_init(&c, NULL, 0);
+    c.stack = (char*)LEPT_MALLOC(c.size = LEPT_PARSE_STRINGIFY_INIT_SIZE);
     assert(c.stack != NULL);
-    c.top = 0;
     //将节点数据结构中保存的值进行字符串化, 并存入输出缓冲区
-    lept_stringify_value(&c, v);
+    if (lept_stringify_value(&c, v) != LEPT_STRINGIFY_OK) {
+        LEPT_FREE(c.stack);
+        if (length)
+            *length = 0;
+        return NULL;
+    }
     //传入非空指针, 那么就可以获取生成的json字符串长度;
     if (length)
         *length = c.top;
@@ -719,31 +4064,103 @@ char* lept_stringify(const lept_value* v, size_t* length) {
     return c.stack;
 }
 
+/*流式输出部分*/
+struct lept_output{
+    lept_writer writer;
+    void* ctx;
+    int error; //writer返回0之后不再调用它
+};
+
+//把输出缓冲区中的内容交给writer, 然后清空缓冲区
+static void lept_content_flush(lept_content* c){
+    lept_output* out = c->out;
+    if (c->top > 0 && out->error == LEPT_STRINGIFY_OK && !out->writer(out->ctx, c->stack, c->top))
+        out->error = LEPT_STRINGIFY_WRITE_ERROR;
+    c->top = 0;
+}
+
+//写入一段连续的文本; 输出到writer时, 放不进缓冲区的长文本在清空缓冲区之后直接交给writer
+static void lept_content_write(lept_content* c, const char* s, size_t len) {
+    if (c->out && c->top + len >= c->size) {
+        lept_content_flush(c);
+        if (len >= c->size) {
+            if (c->out->error == LEPT_STRINGIFY_OK && !c->out->writer(c->out->ctx, s, len))
+                c->out->error = LEPT_STRINGIFY_WRITE_ERROR;
+            return;
+        }
+    }
+    memcpy(lept_content_push(c, len), s, len);
+}
+
+int lept_stringify_to(const lept_value* v, lept_writer writer, void* ctx) {
+    char buffer[LEPT_STRINGIFY_BUFFER_SIZE];
+    lept_content c;
+    lept_output out;
+    int ret;
+    assert(v != NULL && writer != NULL);
+    out.writer = writer;
+    out.ctx = ctx;
+    out.error = LEPT_STRINGIFY_OK;
+    lept_content_init(&c, NULL, 0);
+    c.stack = buffer;
+    c.size = sizeof(buffer);
+    c.out = &out;
+    ret = lept_stringify_value(&c, v);
+    lept_content_flush(&c);
+    return ret != LEPT_STRINGIFY_OK ? ret : out.error;
+}
+
+//不使用递归: 数组和对象中的子数组和子对象先复制到一个临时的lept_content中, 父节点的空间可以立即释放,
+//之后再逐个取出释放, 调用栈的深度与嵌套深度无关
 void lept_free(lept_value* v){
+    lept_content work;
+    lept_value cur;
+    size_t i;
     assert(v != NULL);
-    size_t i = 0;
-    switch(v->type){
-        case LEPT_STRING: 
-            free(v->u.s.s);
-            v->u.s.s = NULL;
-            break;
-        case LEPT_ARRAY:
-            for( i = 0; i < v->u.a.size; i++){
-                lept_free(&v->u.a.e[i]);    
-            }
-            free(v->u.a.e);
-            v->u.a.e = NULL;
-            break;
-        case LEPT_OBJECT:
-             for (i = 0; i < v->u.o.size; i++) {
-                free(v->u.o.m[i].key);
-                lept_free(&v->u.o.m[i].v);
-            }
-            free(v->u.o.m);
-            break;
-        default:
-            break;
+    //arena中的节点由arena统一回收, 尚未展开的容器不持有动态空间
+    if(v->flags & (LEPT_VALUE_ARENA | LEPT_VALUE_LAZY)){
+        lept_init(v);
+        return;
     }
-
-    lept_init(v);
-}
\ No newline at end of file
+    lept_content_init(&work, NULL, 0);
+    cur = *v;
+    while(1){
+        switch(cur.type){
+            case LEPT_STRING: 
+                if (!(cur.flags & (LEPT_VALUE_VIEW | LEPT_VALUE_INLINE)))
+                    LEPT_FREE(cur.u.s.s);
+                break;
+            case LEPT_ARRAY:
+                for( i = 0; i < cur.u.a.size; i++){
+                    lept_value* e = &cur.u.a.e[i];
+                    if(e->type == LEPT_STRING && !(e->flags & (LEPT_VALUE_ARENA | LEPT_VALUE_VIEW | LEPT_VALUE_INLINE)))
+                        LEPT_FREE(e->u.s.s);
+                    else if((e->type == LEPT_ARRAY || e->type == LEPT_OBJECT) && !(e->flags & (LEPT_VALUE_ARENA | LEPT_VALUE_LAZY)))
+                        memcpy(lept_content_push(&work, sizeof(lept_value)), e, sizeof(lept_value));
+                }
+                LEPT_FREE(cur.u.a.e);
+                break;
+            case LEPT_OBJECT:
+                for (i = 0; i < cur.u.o.size; i++) {
+                    lept_value* e = &cur.u.o.m[i].v;
+                    if(!(cur.u.o.m[i].keyFlags & (LEPT_VALUE_VIEW | LEPT_VALUE_INTERNED)))
+                        LEPT_FREE(cur.u.o.m[i].key);
+                    if(e->type == LEPT_STRING && !(e->flags & (LEPT_VALUE_ARENA | LEPT_VALUE_VIEW | LEPT_VALUE_INLINE)))
+                        LEPT_FREE(e->u.s.s);
+                    else if((e->type == LEPT_ARRAY || e->type == LEPT_OBJECT) && !(e->flags & (LEPT_VALUE_ARENA | LEPT_VALUE_LAZY)))
+                        memcpy(lept_content_push(&work, sizeof(lept_value)), e, sizeof(lept_value));
+                }
+                LEPT_FREE(cur.u.o.m);
+                break;
+            default:
+                break;
+        }
+        //取出下一个待释放的数组或对象; arena中和尚未展开的容器在压入之前就已经跳过
+        if(work.top == 0){
+            LEPT_FREE(work.stack);
+            lept_init(v);
+            return;
+        }
+        memcpy(&cur, lept_content_pop(&work, sizeof(lept_value)), sizeof(lept_value));
+    }
+}
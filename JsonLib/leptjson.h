@@ -4,6 +4,7 @@
 #define LEPTJSON_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 /*
 定义json中的六种数据类型
@@ -30,16 +31,30 @@ struct lept_value{
         struct {lept_member* m; size_t size; }o; //object
         struct {lept_value* e; size_t size;}a; //array
         struct{char* s; size_t len;}s;    //string
+        struct{char s[sizeof(char*) + sizeof(size_t) - 1]; unsigned char len;}ss; //LEPT_VALUE_INLINE: 短字符串直接存放在节点中
+        struct{const char* json; size_t len;}l; //LEPT_VALUE_LAZY: 尚未展开的数组或对象在json文本中的范围
         double n;                         //number
     }u;
     
     lept_type type; //通过 `type` 来决定它现时是哪种类型,可以通过type直接为bool类型为true或false;
+    unsigned char flags; //节点的标志位, 见下面的LEPT_VALUE_*
 };
 
+/* lept_value 的标志位 */
+#define LEPT_VALUE_ARENA 0x01   //节点的动态空间来自lept_arena, lept_free不会释放它们
+#define LEPT_VALUE_INDEXED 0x02 //对象的成员数组之后紧跟着键值的哈希索引
+#define LEPT_VALUE_VIEW 0x04    //字符串直接指向解析的json文本, 不以'\0'结尾, lept_free不会释放它
+#define LEPT_VALUE_LAZY 0x08    //数组或对象尚未展开, u.l记录它的文本范围, 需要调用lept_expand展开
+#define LEPT_VALUE_MISSING 0x10 //lept_parse_select中没有找到的路径, 节点为null
+#define LEPT_VALUE_INLINE 0x20  //字符串存放在u.ss中, 以'\0'结尾, 没有单独分配空间
+#define LEPT_VALUE_INTERNED 0x40 //键值来自lept_intern驻留池, 只用于keyFlags; lept_free不会释放它
+
 /*  'lept_member' 是一个 'lept_value' 加上键的字符串 */
+//keyLen和keyFlags共用一个8字节, 成员的大小仍然是一个指针, 8字节和一个lept_value
 struct lept_member{
     char* key;     //对象成员键值
-    size_t keyLen; //键值长度
+    uint32_t keyLen; //键值长度, 更长的键值解析时返回LEPT_PARSE_KEY_TOO_LONG
+    unsigned char keyFlags; //键值的标志位, 只使用LEPT_VALUE_VIEW和LEPT_VALUE_INTERNED
     lept_value v; // 对象成员的值的数据结构;
 };
 
@@ -59,22 +74,220 @@ enum{
     LEPT_PARSE_MISS_ARRAY_ELEMENT, //缺少数组元素错误码
     LEPT_PARSE_MISS_KEY,            //对象成员键值缺少'"'
     LEPT_PARSE_MISS_COLON,           //缺少冒号
-    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET //缺少逗号或者右花括号
+    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, //缺少逗号或者右花括号
+    LEPT_PARSE_FILE_ERROR,          //无法打开或者映射json文件
+    LEPT_PARSE_TERMINATED,          //SAX事件处理函数中止了解析
+    LEPT_PARSE_DEPTH_EXCEEDED,      //数组和对象的嵌套深度超过LEPT_PARSE_MAX_DEPTH
+    LEPT_PARSE_NOT_FOUND,           //lept_pointer_parse没有找到指针指向的值
+    LEPT_PARSE_KEY_TOO_LONG         //对象成员的键值超过UINT32_MAX字节
 };
 
+//数组和对象的最大嵌套深度, 超过时返回LEPT_PARSE_DEPTH_EXCEEDED; 解析不使用递归, 这个限制只用于拒绝恶意的输入
+#ifndef LEPT_PARSE_MAX_DEPTH
+#define LEPT_PARSE_MAX_DEPTH 1024
+#endif
+
+/* lept_stringify_to的返回值 */
+enum{
+    LEPT_STRINGIFY_OK = 0,
+    LEPT_STRINGIFY_WRITE_ERROR,     //writer返回0, 生成被中止
+    LEPT_STRINGIFY_PARSE_ERROR      //尚未展开的数组或对象中有语法错误
+};
+
+//arena分配器: 从大块内存中顺序分配, 整个文档的节点可以通过重置arena一次性释放
+typedef struct lept_arena_chunk lept_arena_chunk;
+typedef struct{
+    lept_arena_chunk* head; //内存块链表的头部
+    lept_arena_chunk* cur;  //当前用于分配的内存块
+    size_t used;            //当前内存块中已经使用的字节数
+    size_t chunk_size;      //每次申请的内存块的默认大小
+}lept_arena;
+
+//json生成器的输出函数: 依次收到生成的json文本片段, 返回非0表示写入成功, 返回0中止生成
+typedef int (*lept_writer)(void* ctx, const char* data, size_t len);
+typedef struct lept_output lept_output;
+
+//键值驻留池: 内容相同的键值只保存一份, 可以在多个文档和多个线程之间共享
+typedef struct lept_intern lept_intern;
+
 //存储解析过程中json文本的字符串指针和动态空间指针, 以及空间的大小和顶部
 typedef struct{
     const char* json;   //json文本中的字符指针
+    const char* end;    //json文本结尾的下一个位置
     char* stack;        //动态的堆栈
     size_t size;        //size 是当前的堆栈容量
     size_t top;         //top 是当前栈顶的位置索引
+    lept_arena* arena;  //不为NULL时, 节点的动态空间从arena中分配
+    lept_output* out;   //不为NULL时, stack是固定大小的输出缓冲区, 写满后交给writer
+    int view;           //不为0时, 没有转义字符的字符串和键值直接指向json文本
+    int lazy;           //不为0时, 内层的数组和对象只记录文本范围, 不展开
+    lept_intern* intern; //不为NULL时, 键值从驻留池中获取
+    int index;          //不为0时, 成员较多的对象在解析时建立哈希索引
 }lept_content;
 
 //初始化节点类型为LEPT_NULL
-#define lept_init(v)  do { (v)->type = LEPT_NULL; } while(0)
+#define lept_init(v)  do { (v)->type = LEPT_NULL; (v)->flags = 0; } while(0)
 
 //解析json文本的接口, 成功返回LEPT_PARSE_OK==0, 错误返回错误码
 int lept_parse(lept_value* v, const char* json);
+//解析长度为len的json文本, 文本不需要以'\0'结尾, 解析过程不会读取json + len之后的内容;
+//文本中出现的'\0'字符被当作无效字符处理
+int lept_parse_n(lept_value* v, const char* json, size_t len);
+//把文件映射到内存中直接解析, 不需要把文件内容读入额外的缓冲区; 无法打开或映射文件时返回LEPT_PARSE_FILE_ERROR
+int lept_parse_file(lept_value* v, const char* path);
+
+//初始化arena, chunk_size为每个内存块的大小, 为0时使用默认大小
+void lept_arena_init(lept_arena* a, size_t chunk_size);
+//重置arena, 之前分配的所有节点一次性失效, 已申请的内存块保留下来供之后的解析复用
+void lept_arena_reset(lept_arena* a);
+//释放arena申请的所有内存块
+void lept_arena_free(lept_arena* a);
+//使用arena解析json文本, 节点中的字符串, 数组和对象都从arena中分配;
+//解析结果不需要调用lept_free, 重置或释放arena之后节点即失效
+int lept_parse_arena(lept_arena* a, lept_value* v, const char* json);
+//零拷贝解析长度为len的json文本: 没有转义字符的字符串和键值不复制, 直接指向json文本中的内容(LEPT_VALUE_VIEW),
+//只有含有转义字符的才解码到新申请的空间; 在lept_free之前json必须保持有效且不被修改;
+//指向json文本的字符串不以'\0'结尾, 需要配合lept_get_string_length和lept_get_object_key_length使用
+int lept_parse_view(lept_value* v, const char* json, size_t len);
+//惰性解析长度为len的json文本: 只展开根节点这一层, 内层的数组和对象只检查括号是否配对并记录文本范围(LEPT_VALUE_LAZY);
+//访问它们的元素或成员之前必须先调用lept_expand展开, lept_get_*和lept_find_*不会修改节点, 遇到未展开的节点时断言失败,
+//定义NDEBUG时把它当作空的容器(个数为0, 元素, 成员和查找结果为NULL);
+//在lept_free之前json必须保持有效且不被修改; 内层容器中的语法错误在展开时才会发现
+//只读的接口可以在多个线程中同时调用, lept_expand修改节点, 不能与访问同一个节点的其他调用同时进行
+int lept_parse_lazy(lept_value* v, const char* json, size_t len);
+//展开惰性的数组或对象的一层, 返回解析结果; 出错时v保持不变, 仍然是未展开的节点, 再次调用返回同样的错误码;
+//其他节点直接返回LEPT_PARSE_OK
+int lept_expand(lept_value* v);
+
+//SAX事件处理函数: 解析过程中按文本顺序回调, 不构建节点树;
+//返回非0继续解析, 返回0中止解析, lept_parse_sax返回LEPT_PARSE_TERMINATED; 为NULL的回调会被跳过
+//string和key回调中的字符串已经完成转义, 不以'\0'结尾, 只在回调期间有效
+typedef struct{
+    int (*null_value)(void* ctx);
+    int (*boolean)(void* ctx, int b);
+    int (*number)(void* ctx, double n);
+    int (*string)(void* ctx, const char* s, size_t len);
+    int (*start_object)(void* ctx);
+    int (*key)(void* ctx, const char* s, size_t len);
+    int (*end_object)(void* ctx, size_t size);  //size为对象的成员个数
+    int (*start_array)(void* ctx);
+    int (*end_array)(void* ctx, size_t size);   //size为数组的元素个数
+}lept_handler;
+
+//以SAX事件的方式解析长度为len的json文本, ctx原样传递给每个回调;
+//文本有错误时, 出错位置之前的事件已经被回调
+int lept_parse_sax(const lept_handler* h, void* ctx, const char* json, size_t len);
+
+//增量解析器: json文本可以分成任意多段依次传入, 段与段的边界可以落在字符串, 转义序列或数字的中间
+typedef struct lept_parser_frame lept_parser_frame;
+typedef struct{
+    lept_content c;             //已经解析出的数组元素和对象成员暂存在c的堆栈中
+    lept_parser_frame* frames;  //尚未结束的数组和对象, 每层一个
+    size_t depth;               //当前的嵌套深度
+    size_t frame_cap;           //frames的容量
+    char* pending;              //被段边界截断的字符串, 数字或字面量暂存在这里, 直到读到它的结尾
+    size_t pending_len;         //pending中暂存的字节数
+    size_t pending_cap;         //pending的容量
+    lept_value root;            //已经解析完成的根节点
+    int state;                  //下一个期待的语法成分
+    int error;                  //出错后记录错误码, 之后的输入都直接返回它
+    char token;                 //正在暂存的标量的首字符, 0表示没有
+    char escaped;               //暂存的字符串的最后一个字符是未处理的'\\'
+    lept_arena* arena;          //不为NULL时, lept_parser_parse的结果从arena中分配
+    lept_intern* intern;        //不为NULL时, lept_parser_parse的键值从驻留池中获取
+    int index;                  //不为0时, lept_parser_parse为成员较多的对象建立哈希索引
+}lept_parser;
+
+//初始化增量解析器
+void lept_parser_init(lept_parser* p);
+//传入下一段json文本, 成功返回LEPT_PARSE_OK; 出错时返回错误码, 之后的调用都返回同一个错误码
+int lept_parser_feed(lept_parser* p, const char* chunk, size_t len);
+//结束输入, 返回值与一次性调用lept_parse_n解析全部文本相同; 成功时把根节点移动到v中;
+//之后解析器回到初始状态, 可以开始解析下一个json文本
+int lept_parser_finish(lept_parser* p, lept_value* v);
+//释放解析器中的所有空间, 包括尚未完成的节点
+void lept_parser_free(lept_parser* p);
+//一次性解析整个json文本, 结果与lept_parse_n相同, 但复用解析器中的堆栈:
+//堆栈在调用之间保留容量, 连续解析大量小文档时不再反复申请和释放; 不能在增量解析途中调用
+int lept_parser_parse_n(lept_parser* p, lept_value* v, const char* json, size_t len);
+int lept_parser_parse(lept_parser* p, lept_value* v, const char* json);
+//解析多个直接拼接或以空白分隔的根节点(例如"{...}{...} [...]"): 从json + *offset开始解析一个根节点,
+//成功时把*offset移到它和之后的空白的下一个位置, *offset == len表示已经读完; 出错时*offset不变
+//与lept_parser_parse一样复用解析器的堆栈和arena
+int lept_parser_parse_next(lept_parser* p, lept_value* v, const char* json, size_t len, size_t* offset);
+//下面的设置同时作用于lept_parser_parse*和增量解析; 增量解析在开始一个新的json文本时取用设置,
+//在lept_parser_finish之前修改设置只影响下一个文本
+//设置节点使用的arena, NULL表示使用LEPT_MALLOC
+void lept_parser_set_arena(lept_parser* p, lept_arena* a);
+//设置驻留池: 对象的键值从池中获取(LEPT_VALUE_INTERNED), 不再单独分配;
+//池必须比解析出的节点存活得更久; 多个线程的解析器可以共享同一个池; NULL表示不使用
+void lept_parser_set_intern(lept_parser* p, lept_intern* t);
+//设置是否为成员较多的对象建立哈希索引, 使lept_find_object_index的查找为O(1);
+//索引和成员数组在同一块空间中分配, 默认不建立
+void lept_parser_set_index(lept_parser* p, int enable);
+
+//创建键值驻留池, 池中的字符串在lept_intern_reset或lept_intern_free之前一直有效
+//limit为池中字符串(含'\0')的总字节数的上限, 平均分给各个分片; 0表示不限制
+lept_intern* lept_intern_create(size_t limit);
+//清空池并复用已经申请的内存; 之前得到的驻留字符串和使用它们作为键值的节点都不能再使用
+void lept_intern_reset(lept_intern* t);
+void lept_intern_free(lept_intern* t);
+//返回与s内容相同的驻留字符串, 以'\0'结尾, 不能修改; 内容相同的字符串总是得到同一个指针
+//池满了时返回NULL, 此时解析器单独分配键值, 与不使用池相同
+//查找时用lept_find_object_value_interned, 驻留的成员键值只比较指针
+//lept_intern_n(包括共享池的解析器)可以在多个线程中同时调用; lept_intern_reset和lept_intern_free不能与其他调用同时进行
+const char* lept_intern_n(lept_intern* t, const char* s, size_t len);
+
+//NDJSON(JSON Lines): 每行一个json文本, 只有空白的行被跳过, 其余的行按顺序编号为记录0, 1, 2...
+//文本按整行分给threads个线程并行解析, 每个线程使用一个lept_parser; threads为0时使用所有处理器
+//解析全部记录, 成功时v为按顺序包含所有记录的数组; 出错时返回序号最小的出错记录的错误码, v为null
+int lept_parse_ndjson(lept_value* v, const char* json, size_t len, size_t threads);
+//每条记录解析后的回调: 解析失败时error为错误码, v为null; 回调返回后v被释放, 需要保留时把*v复制走并对v调用lept_init;
+//返回非0继续, 返回0中止全部线程的解析, 其他线程在中止前可能还会回调少量记录; 回调会在多个线程中同时调用, 记录的先后顺序不确定
+typedef int (*lept_record_handler)(void* ctx, size_t index, lept_value* v, int error);
+//逐条回调, 出错的记录不会中止解析; 返回序号最小的出错记录的错误码, 回调中止时返回LEPT_PARSE_TERMINATED
+int lept_parse_ndjson_each(const char* json, size_t len, size_t threads, lept_record_handler fn, void* ctx);
+//把文件映射到内存中, 与lept_parse_ndjson_each相同地逐条回调
+int lept_parse_ndjson_file(const char* path, size_t threads, lept_record_handler fn, void* ctx);
+
+//并行解析单个大文档: 根节点是数组时, 先并行建立结构索引找到各个元素的范围, 再用threads个线程并行解析元素;
+//threads为0时使用所有处理器; 根节点不是数组或者文档较小时直接使用lept_parse_n; 结果和错误码都与lept_parse_n相同
+int lept_parse_parallel(lept_value* v, const char* json, size_t len, size_t threads);
+
+//tape: 把整个文档解析到一块连续的64位字数组中, 不构建节点树, 整个文档只占用一块动态空间;
+//每个值以一个标签字开头, 高8位为lept_type, 低56位为附加信息:
+//  null/false/true 占1个字; number 的标签字之后是double的二进制表示, 共2个字;
+//  string 的附加信息为长度, 之后是以'\0'结尾的字符串, 补齐到8字节的整数倍;
+//  array/object 的附加信息为整个容器占用的字数, 第2个字是元素或成员的个数, 之后依次是各个元素,
+//  对象则是键值(与string相同的格式)和值交替排列
+typedef struct { uint64_t w; } lept_tape_value;
+typedef struct{
+    lept_tape_value* words; //tape的内容, 第一个值是根节点
+    size_t size;            //tape的字数
+}lept_tape;
+
+//把长度为len的json文本解析为tape, 返回值与lept_parse_n相同; 失败时t->words为NULL
+int lept_parse_tape(lept_tape* t, const char* json, size_t len);
+//释放tape的空间, 之后从中取得的lept_tape_value指针都失效
+void lept_tape_free(lept_tape* t);
+//以下只读接口与lept_get_*对应, 参数为指向值的标签字的指针
+const lept_tape_value* lept_tape_root(const lept_tape* t);
+//tape中紧跟在v之后的值, 跳过数组和对象的时间复杂度为O(1); 可以用来依次访问元素, 或者交替访问对象的键值和值
+const lept_tape_value* lept_tape_next(const lept_tape_value* v);
+lept_type lept_tape_get_type(const lept_tape_value* v);
+int lept_tape_get_boolean(const lept_tape_value* v);
+double lept_tape_get_number(const lept_tape_value* v);
+const char* lept_tape_get_string(const lept_tape_value* v);
+size_t lept_tape_get_string_length(const lept_tape_value* v);
+size_t lept_tape_get_array_size(const lept_tape_value* v);
+//按索引访问需要依次跳过之前的元素, 时间复杂度为O(index)
+const lept_tape_value* lept_tape_get_array_element(const lept_tape_value* v, size_t index);
+size_t lept_tape_get_object_size(const lept_tape_value* v);
+const char* lept_tape_get_object_key(const lept_tape_value* v, size_t index);
+size_t lept_tape_get_object_key_length(const lept_tape_value* v, size_t index);
+const lept_tape_value* lept_tape_get_object_value(const lept_tape_value* v, size_t index);
+//逐个比较键值, 返回第一个匹配的成员的值, 不存在时返回NULL
+const lept_tape_value* lept_tape_find_object_value(const lept_tape_value* v, const char* key, size_t klen);
 
 //获取当前节点的类型
 lept_type lept_get_type(const lept_value* v);
@@ -110,10 +323,46 @@ size_t lept_get_object_key_length(const lept_value* v, size_t index);
 //对象成员对应的值
 lept_value* lept_get_object_value(const lept_value* v, size_t index);
 
-//Json生成器
+//查找对象中键值为key的成员, 有重复的键值时返回第一个;
+//对象有哈希索引(见lept_parser_set_index)时查找的时间复杂度为O(1), 否则逐个比较
+#define LEPT_KEY_NOT_EXIST ((size_t)-1)
+//返回成员的索引, 不存在时返回LEPT_KEY_NOT_EXIST
+size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen);
+//返回成员的值, 不存在时返回NULL
+lept_value* lept_find_object_value(const lept_value* v, const char* key, size_t klen);
+//key必须是lept_intern_n从解析v时使用的驻留池中返回的字符串: 驻留的成员键值与key指针不同时直接跳过, 不比较内容;
+//池满了之后单独分配的键值仍然比较内容
+lept_value* lept_find_object_value_interned(const lept_value* v, const char* key, size_t klen);
+
+//JSON Pointer(RFC 6901), 例如"/a/b/0"; 编译时解码"~0"和"~1"并计算每一段的哈希和数组索引, 可以在多个文档之间重复使用
+typedef struct lept_pointer lept_pointer;
+//编译json pointer, 空字符串指向根节点; 格式错误时返回NULL; 结果用lept_pointer_free释放
+lept_pointer* lept_pointer_compile(const char* path);
+void lept_pointer_free(lept_pointer* p);
+//返回p指向的值, 不存在时返回NULL; 数组索引必须是不以0开头的十进制数, "-"不指向任何元素;
+//路径经过尚未展开的数组或对象(见lept_parse_lazy)时也返回NULL
+lept_value* lept_pointer_get(const lept_value* v, const lept_pointer* p);
+//直接在长度为len的json文本中查找p指向的值, 只完整解析这个值: 路径之外的数组和对象只检查括号配对后跳过,
+//找到之后不再读取剩余的文本; 成功返回LEPT_PARSE_OK, 不存在时返回LEPT_PARSE_NOT_FOUND, 出错时v为null
+int lept_pointer_parse(lept_value* v, const char* json, size_t len, const lept_pointer* p);
+
+//lept_parse_select的选项: 校验整个文本, 否则所有路径都找到之后立即停止, 不读取剩余的文本
+#define LEPT_SELECT_VALIDATE 0x01
+//一次扫描长度为len的json文本, 把n个路径指向的值分别解析到values[0..n-1]中; 路径之外的值不申请空间,
+//只检查括号配对后跳过(LEPT_SELECT_VALIDATE时按完整的语法校验); 全部找到返回LEPT_PARSE_OK,
+//有路径不存在时返回LEPT_PARSE_NOT_FOUND, 对应的值为带有LEPT_VALUE_MISSING标志的null; 出错时values都为null
+int lept_parse_select(const char* json, size_t len, const lept_pointer* const* paths, size_t n, lept_value* values, int flags);
+
+//Json生成器; 尚未展开的数组和对象会临时解析后输出, 其中有语法错误时返回NULL
 char* lept_stringify(const lept_value* v, size_t* length);
+//把生成的json文本分段交给writer(如写入文件, socket), 输出只使用一块固定大小的栈上缓冲区, 不会缓存整个文本;
+//生成不使用递归, 嵌套的数组和对象只需要一个按深度增长的小遍历栈
+//成功返回LEPT_STRINGIFY_OK; writer返回0之后不会再被调用, 最终返回LEPT_STRINGIFY_WRITE_ERROR;
+//尚未展开的容器中有语法错误时停止输出, 返回LEPT_STRINGIFY_PARSE_ERROR
+int lept_stringify_to(const lept_value* v, lept_writer writer, void* ctx);
 
 //释放string类型节点的指针,存放string字符串的空间是动态的, 并将节点类型置NULL
+//来自arena的节点(LEPT_VALUE_ARENA)不会被释放, 只会被置为NULL
 void lept_free(lept_value* v);
 
 #endif
\ No newline at end of file
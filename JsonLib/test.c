@@ -65,6 +65,19 @@ static int test_pass = 0;   //测试通过的数量
         lept_free(&v);\
     }while(0);
 
+//解析json的前len个字符, 复制到恰好len字节的动态空间中, 越界读取可以被内存检查工具发现
+#define TEST_PARSE_N(error, finalType, json, len) \
+    do{ \
+        lept_value  v;\
+        char* buf = (char*)malloc((len) ? (len) : 1);\
+        memcpy(buf, json, len);\
+        lept_init(&v);\
+        EXPECT_EQ_INT(error, lept_parse_n(&v, buf, len));\
+        EXPECT_EQ_INT(finalType, lept_get_type(&v));\
+        lept_free(&v);\
+        free(buf);\
+    }while(0);
+
 #define TEST_NUMBER(except, json) \
     do{ \
         lept_value  v;\
@@ -127,6 +140,62 @@ static void test_parse_number() {
     TEST_NUMBER(1.234E+10, "1.234E+10")
     TEST_NUMBER(1.234E-10, "1.234E-10")
     TEST_NUMBER(0.0, "1e-10000") /* must underflow */
+
+    TEST_NUMBER(1.0000000000000002, "1.0000000000000002"); /* the smallest number > 1 */
+    TEST_NUMBER( 4.9406564584124654e-324, "4.9406564584124654e-324"); /* minimum denormal */
+    TEST_NUMBER(-4.9406564584124654e-324, "-4.9406564584124654e-324");
+    TEST_NUMBER( 2.2250738585072009e-308, "2.2250738585072009e-308");  /* Max subnormal double */
+    TEST_NUMBER(-2.2250738585072009e-308, "-2.2250738585072009e-308");
+    TEST_NUMBER( 2.2250738585072014e-308, "2.2250738585072014e-308");  /* Min normal positive double */
+    TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
+    TEST_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
+    TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+}
+
+//数字的转换结果必须和正确舍入的strtod完全一致, 包括超过19位有效数字和舍入到偶数的情况
+static void test_parse_number_exact() {
+    static const char* numbers[] = {
+        "0.1", "0.3", "123456.789", "9007199254740993", "9007199254740992.5",
+        "2.2250738585072011e-308", "2.2250738585072012e-308", "2.4703282292062328e-324",
+        "1.7976931348623158e308", "7.2057594037927933e+16", "1e23", "8.533e+68",
+        "4.1006e-184", "9.998e+307", "9.9538452227e-280", "6.47660115e-260",
+        "123456789012345678901234567890", "0.1000000000000000055511151231257827",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124",
+        "1.00000000000000011102230246251565404236316680908203126",
+        "0.000000000000000000000000000000000000000000001e300", "1e-400", "-0.0",
+        "9007199254740993.0000000000000000001", "9007199254740993.00000000000000000000",
+        "-9007199254740995.00000000000000000000", "2.2250738585072011360574097967091319759e-308"
+    };
+    size_t i, zeros = 1000000;
+    char* json = (char*)malloc(zeros + 16);
+    lept_value v;
+    for (i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+        double expect = strtod(numbers[i], NULL);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, numbers[i]));
+        EXPECT_EQ_INT(0, memcmp(&expect, &v.u.n, sizeof(double)));
+    }
+
+    //指数要先和小数点的位移合并才能限制大小, 0.(10^6个0)1e1000010 = 1e9
+    memcpy(json, "0.", 2);
+    memset(json + 2, '0', zeros);
+    memcpy(json + 2 + zeros, "1e1000010", 9);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, json, zeros + 11));
+    EXPECT_EQ_DOUBLE(1e9, v.u.n);
+
+    //2^53+1恰好是中点, 768位有效数字之后的非0数字也要参与舍入
+    memcpy(json, "9007199254740993.", 17);
+    memset(json + 17, '0', 1000);
+    json[17 + 1000] = '1';
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, json, 17 + 1001));
+    EXPECT_EQ_DOUBLE(9007199254740994.0, v.u.n);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, json, 17 + 1000));
+    EXPECT_EQ_DOUBLE(9007199254740992.0, v.u.n);
+    free(json);
 }
 
 static void test_parse_except_value(){
@@ -161,6 +230,8 @@ static void test_parse_root_not_singular(){
 static void test_parse_number_too_big(){
     TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, LEPT_NULL, "1.7e309")
     TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, LEPT_NULL, "-1.7e309")
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, LEPT_NULL, "1.7976931348623159e308")
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, LEPT_NULL, "1e99999999999")
 }
 
 static void test_parse_string(){
@@ -176,6 +247,48 @@ static void test_parse_string(){
     TEST_STRING_PARSE("\xF0\x9D\x84\x9E", "\"\\ud834\\udd1e\"");  /* G clef sign U+1D11E */
 }
 
+//测试较长的字符串, 特殊字符出现在不同的位置, 覆盖字符串扫描的整段拷贝路径
+static void test_parse_long_string() {
+    char json[256], expect[256];
+    size_t i, j, len;
+    for (i = 0; i < 80; i++) {
+        lept_value v;
+        //前i个字节为无需转义的字符(包含UTF8多字节字符), 然后是一个转义字符, 再接一段普通字符
+        json[0] = '"';
+        for (j = 0; j < i; j++)
+            json[1 + j] = expect[j] = (j % 7 == 3) ? '\xE4' : (char)('a' + j % 26);
+        json[1 + i] = '\\'; json[2 + i] = 'n';
+        expect[i] = '\n';
+        for (j = 0; j < 40; j++)
+            json[3 + i + j] = expect[i + 1 + j] = (char)('A' + j % 26);
+        len = i + 41;
+        json[3 + i + 40] = '"';
+        json[4 + i + 40] = '\0';
+
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_STRING, lept_get_type(&v));
+        EXPECT_EQ_SIZE_T(len, lept_get_string_length(&v));
+        EXPECT_EQ_INT(0, memcmp(expect, lept_get_string(&v), len));
+        lept_free(&v);
+
+        //控制字符出现在长字符串中间
+        json[1 + i] = '\x01';
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_CHAR, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        lept_free(&v);
+
+        //缺少结尾的引号
+        json[1 + i] = 'x';
+        json[3 + i + 40] = '\0';
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        lept_free(&v);
+    }
+}
+
 static void test_parse_missing_quotation_mark() {
     TEST_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK, LEPT_NULL, "\"");
     TEST_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK, LEPT_NULL, "\"abc");
@@ -259,6 +372,63 @@ static void test_parse_array(){
     lept_free(&v);
 
 }
+//测试按键值查找对象成员, 开启索引时成员较多的对象使用哈希索引
+static void test_find_object() {
+    lept_value v;
+    char json[4096], key[16];
+    size_t i, n = 0;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":1,\"bb\":2,\"a\":3,\"\":4}"));
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&v, "a", 1));
+    EXPECT_EQ_SIZE_T(1, lept_find_object_index(&v, "bb", 2));
+    EXPECT_EQ_SIZE_T(3, lept_find_object_index(&v, "", 0));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_find_object_index(&v, "b", 1));
+    EXPECT_EQ_DOUBLE(2.0, lept_get_number(lept_find_object_value(&v, "bb", 2)));
+    EXPECT_TRUE((lept_find_object_value(&v, "c", 1) == NULL));
+    lept_free(&v);
+
+    //生成有200个成员的对象, 最后一个成员和第一个成员的键值重复
+    json[n++] = '{';
+    for (i = 0; i < 200; i++)
+        n += sprintf(json + n, "\"key%d\":%d,", (int)i, (int)i);
+    n += sprintf(json + n, "\"key0\":-1}");
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_INT(0, v.flags);
+    EXPECT_EQ_SIZE_T(199, lept_find_object_index(&v, "key199", 6));
+    lept_free(&v);
+
+    //开启索引的解析器为成员较多的对象建立哈希索引, 哈希索引和成员数组一起从arena中分配
+    {
+        lept_parser p;
+        lept_arena a;
+        lept_parser_init(&p);
+        lept_parser_set_index(&p, 1);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+        EXPECT_EQ_INT(LEPT_VALUE_INDEXED, v.flags);
+        EXPECT_EQ_SIZE_T(201, lept_get_object_size(&v));
+        for (i = 0; i < 200; i++) {
+            size_t len = sprintf(key, "key%d", (int)i);
+            EXPECT_EQ_SIZE_T(i, lept_find_object_index(&v, key, len));
+            EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_find_object_value(&v, key, len)));
+        }
+        EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_find_object_index(&v, "key200", 6));
+        EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_find_object_index(&v, "key", 3));
+        lept_free(&v);
+
+        lept_arena_init(&a, 0);
+        lept_parser_set_arena(&p, &a);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+        EXPECT_EQ_INT(LEPT_VALUE_ARENA | LEPT_VALUE_INDEXED, v.flags);
+        EXPECT_EQ_SIZE_T(199, lept_find_object_index(&v, "key199", 6));
+        lept_arena_free(&a);
+        lept_parser_free(&p);
+    }
+}
+
 static void test_parse_miss_key() {
     TEST_ERROR(LEPT_PARSE_MISS_KEY, LEPT_NULL, "{:1,");
     TEST_ERROR(LEPT_PARSE_MISS_KEY, LEPT_NULL, "{1:1,");
@@ -341,6 +511,927 @@ static void test_parse_object() {
     lept_free(&v);
 }
 
+//测试使用arena解析, 节点的空间来自arena, 重置后可以复用内存块
+static void test_parse_arena() {
+    lept_arena a;
+    lept_value v;
+    const char* json = "{\"a\":[1,\"abc\",{\"key\":\"value\"}],\"b\":\"Hello\\nWorld\"}";
+    char* json2;
+    size_t length;
+    int round;
+
+    lept_arena_init(&a, 64);
+    for (round = 0; round < 3; round++) {
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_arena(&a, &v, json));
+        EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+        EXPECT_EQ_SIZE_T(2, lept_get_object_size(&v));
+        EXPECT_EQ_STRING("a", lept_get_object_key(&v, 0), lept_get_object_key_length(&v, 0));
+        EXPECT_EQ_SIZE_T(3, lept_get_array_size(lept_get_object_value(&v, 0)));
+        EXPECT_EQ_STRING("Hello\nWorld", lept_get_string(lept_get_object_value(&v, 1)), lept_get_string_length(lept_get_object_value(&v, 1)));
+        json2 = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING("{\"a\":[1,\"abc\",{\"key\":\"value\"}],\"b\":\"Hello\\nWorld\"}", json2, length);
+        free(json2);
+        //arena中的节点调用lept_free是安全的, 只会把节点置为null
+        lept_free(&v);
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        lept_arena_reset(&a);
+    }
+
+    //解析失败时残留的空间同样由arena回收
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse_arena(&a, &v, "{\"a\":[\"abc\"],\"b\":1"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    lept_arena_free(&a);
+}
+
+static void test_parse_view() {
+    lept_value v;
+    lept_value* e;
+    const char* json = "{\"a\":[1,\"abc\",{\"key\":\"value\"}],\"b\\t\":\"Hello\\nWorld\",\"c\":\"\"}";
+    char* json2;
+    size_t length;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_view(&v, json, strlen(json)));
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&v));
+    //没有转义字符的键值和字符串直接指向json文本
+    EXPECT_TRUE((lept_get_object_key(&v, 0) == json + 2));
+    EXPECT_EQ_INT(LEPT_VALUE_VIEW, v.u.o.m[0].keyFlags);
+    //keyFlags放在keyLen之后的空隙中, 不增加成员的大小
+    if (sizeof(void*) == 8)
+        EXPECT_EQ_SIZE_T(40, sizeof(lept_member));
+    e = lept_get_array_element(lept_get_object_value(&v, 0), 1);
+    EXPECT_TRUE((lept_get_string(e) == json + 9));
+    EXPECT_EQ_INT(LEPT_VALUE_VIEW, e->flags);
+    e = lept_find_object_value(lept_get_array_element(lept_get_object_value(&v, 0), 2), "key", 3);
+    EXPECT_EQ_STRING("value", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_EQ_INT(LEPT_VALUE_VIEW, e->flags);
+    //含有转义字符的解码到新申请的空间, 短字符串存放在节点中
+    EXPECT_EQ_STRING("b\t", lept_get_object_key(&v, 1), lept_get_object_key_length(&v, 1));
+    EXPECT_EQ_INT(0, v.u.o.m[1].keyFlags);
+    e = lept_get_object_value(&v, 1);
+    EXPECT_EQ_STRING("Hello\nWorld", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_EQ_INT(LEPT_VALUE_INLINE, e->flags);
+    EXPECT_EQ_SIZE_T(0, lept_get_string_length(lept_get_object_value(&v, 2)));
+    json2 = lept_stringify(&v, &length);
+    EXPECT_EQ_STRING("{\"a\":[1,\"abc\",{\"key\":\"value\"}],\"b\\t\":\"Hello\\nWorld\",\"c\":\"\"}", json2, length);
+    free(json2);
+    //重新设置字符串之后节点持有自己的空间
+    lept_set_string(lept_get_object_value(&v, 2), "xyz", 3);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+
+    //单独的字符串
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_view(&v, "\"abc\"", 5));
+    EXPECT_EQ_INT(LEPT_VALUE_VIEW, v.flags);
+    EXPECT_EQ_STRING("abc", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    //解析失败时不会释放指向json文本的键值和字符串
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse_view(&v, "{\"a\":[\"abc\"],\"b\\n\":\"x\",\"c\":1", 28));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
+//测试不以'\0'结尾的json文本
+static void test_parse_n() {
+    lept_value v;
+    TEST_PARSE_N(LEPT_PARSE_OK, LEPT_ARRAY, "[1,2]garbage", 5)
+    TEST_PARSE_N(LEPT_PARSE_OK, LEPT_TRUE, "truex", 4)
+    TEST_PARSE_N(LEPT_PARSE_OK, LEPT_NUMBER, "-1.5e10", 7)
+    TEST_PARSE_N(LEPT_PARSE_OK, LEPT_STRING, "\"abc\"", 5)
+    TEST_PARSE_N(LEPT_PARSE_OK, LEPT_OBJECT, "{\"a\":{}}", 8)
+    TEST_PARSE_N(LEPT_PARSE_EXCEPT_VALUE, LEPT_NULL, "", 0)
+    TEST_PARSE_N(LEPT_PARSE_EXCEPT_VALUE, LEPT_NULL, "   ", 3)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "nul", 3)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "fals", 4)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "1.", 2)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "1e+", 3)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "-", 1)
+    TEST_PARSE_N(LEPT_PARSE_MISS_QUOTATION_MARK, LEPT_NULL, "\"abc\"", 4)
+    TEST_PARSE_N(LEPT_PARSE_MISS_QUOTATION_MARK, LEPT_NULL, "\"abcdefghijklmnopqrstuvwxyz0123456789\"", 37)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_STRING_ESCAPE, LEPT_NULL, "\"\\", 2)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_HEX, LEPT_NULL, "\"\\u00", 5)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_SURROGATE, LEPT_NULL, "\"\\uD800\\", 8)
+    TEST_PARSE_N(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, LEPT_NULL, "[1,2]", 4)
+    TEST_PARSE_N(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, LEPT_NULL, "{\"a\":1}", 6)
+
+    //文本中出现的'\0'被拒绝
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, LEPT_NULL, "[1,\0]", 5)
+    TEST_PARSE_N(LEPT_PARSE_INVALID_STRING_CHAR, LEPT_NULL, "\"a\0b\"", 5)
+    TEST_PARSE_N(LEPT_PARSE_ROOT_NOT_SINGULAR, LEPT_NULL, "null\0", 5)
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, "\"Hello\\nWorld\" ", 15));
+    EXPECT_EQ_STRING("Hello\nWorld", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, "12345", 2));
+    EXPECT_EQ_DOUBLE(12.0, lept_get_number(&v));
+    lept_free(&v);
+}
+
+//SAX测试: 把收到的事件依次记录成字符串, 第limit个事件之后中止解析
+typedef struct {
+    char trace[256];
+    size_t len;
+    int events;
+    int limit;
+} sax_recorder;
+
+static int sax_event(void* ctx, const char* name, const char* s, size_t len) {
+    sax_recorder* r = (sax_recorder*)ctx;
+    size_t n = strlen(name);
+    memcpy(r->trace + r->len, name, n);
+    memcpy(r->trace + r->len + n, s, len);
+    r->len += n + len;
+    r->trace[r->len++] = ' ';
+    r->trace[r->len] = '\0';
+    return ++r->events != r->limit;
+}
+
+static int sax_null(void* ctx) { return sax_event(ctx, "n", "", 0); }
+static int sax_boolean(void* ctx, int b) { return sax_event(ctx, b ? "t" : "f", "", 0); }
+static int sax_number(void* ctx, double n) {
+    char buffer[32];
+    return sax_event(ctx, "", buffer, (size_t)sprintf(buffer, "%g", n));
+}
+static int sax_string(void* ctx, const char* s, size_t len) { return sax_event(ctx, "s:", s, len); }
+static int sax_start_object(void* ctx) { return sax_event(ctx, "{", "", 0); }
+static int sax_key(void* ctx, const char* s, size_t len) { return sax_event(ctx, "k:", s, len); }
+static int sax_end_object(void* ctx, size_t size) {
+    char buffer[32];
+    return sax_event(ctx, "}", buffer, (size_t)sprintf(buffer, "%d", (int)size));
+}
+static int sax_start_array(void* ctx) { return sax_event(ctx, "[", "", 0); }
+static int sax_end_array(void* ctx, size_t size) {
+    char buffer[32];
+    return sax_event(ctx, "]", buffer, (size_t)sprintf(buffer, "%d", (int)size));
+}
+
+#define TEST_SAX(error, expect, json, stop_at)\
+    do {\
+        sax_recorder r;\
+        r.len = 0;\
+        r.trace[0] = '\0';\
+        r.events = 0;\
+        r.limit = stop_at;\
+        EXPECT_EQ_INT(error, lept_parse_sax(&handler, &r, json, strlen(json)));\
+        EXPECT_EQ_STRING(expect, r.trace, r.len);\
+    } while(0)
+
+static void test_parse_sax() {
+    lept_handler handler = {
+        sax_null, sax_boolean, sax_number, sax_string,
+        sax_start_object, sax_key, sax_end_object, sax_start_array, sax_end_array
+    };
+    TEST_SAX(LEPT_PARSE_OK, "n ", "null", 0);
+    TEST_SAX(LEPT_PARSE_OK, "s:Hello\nWorld ", " \"Hello\\nWorld\" ", 0);
+    TEST_SAX(LEPT_PARSE_OK, "[ ]0 ", "[ ]", 0);
+    TEST_SAX(LEPT_PARSE_OK, "{ }0 ", "{ }", 0);
+    TEST_SAX(LEPT_PARSE_OK, "[ n f t 123 s:abc [ 1 2 ]2 ]6 ", "[ null , false , true , 123 , \"abc\", [ 1, 2 ] ]", 0);
+    TEST_SAX(LEPT_PARSE_OK, "{ k:n n k:a [ 1 ]1 k:o { k:1 1.5 }1 }3 ", "{\"n\":null,\"a\":[1],\"o\":{\"1\":1.5}}", 0);
+
+    //回调返回0时中止解析
+    TEST_SAX(LEPT_PARSE_TERMINATED, "[ n f ", "[null,false,true]", 3);
+    TEST_SAX(LEPT_PARSE_TERMINATED, "{ k:a ", "{\"a\":\"abc\",\"b\":1}", 2);
+    TEST_SAX(LEPT_PARSE_TERMINATED, "[ 1 ]1 ", "[1]", 3);
+
+    //出错之前的事件已经被回调
+    TEST_SAX(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[ 1 ", "[1}", 0);
+    TEST_SAX(LEPT_PARSE_MISS_COLON, "{ k:a ", "{\"a\" 1}", 0);
+    TEST_SAX(LEPT_PARSE_INVALID_STRING_ESCAPE, "[ ", "[\"\\v\"]", 0);
+    TEST_SAX(LEPT_PARSE_ROOT_NOT_SINGULAR, "t ", "true x", 0);
+    TEST_SAX(LEPT_PARSE_EXCEPT_VALUE, "", "", 0);
+
+    //为NULL的回调被跳过
+    handler.number = NULL;
+    handler.start_array = NULL;
+    TEST_SAX(LEPT_PARSE_OK, "n ]2 ", "[1,null]", 0);
+}
+
+//把json文本在每一个位置切成两段, 以及逐字节传入增量解析器, 结果必须和lept_parse_n一致
+static void test_parser_split(const char* json) {
+    lept_parser p;
+    lept_value expect, v;
+    size_t len = strlen(json), i, n1, n2;
+    int ret;
+    char* s1 = NULL;
+    char* s2;
+
+    lept_init(&expect);
+    ret = lept_parse_n(&expect, json, len);
+    if (ret == LEPT_PARSE_OK)
+        s1 = lept_stringify(&expect, &n1);
+    lept_parser_init(&p);
+    for (i = 0; i <= len + 1; i++) {
+        if (i <= len) {
+            lept_parser_feed(&p, json, i);
+            lept_parser_feed(&p, json + i, len - i);
+        }
+        else {
+            size_t j;
+            for (j = 0; j < len; j++)
+                lept_parser_feed(&p, json + j, 1);
+        }
+        EXPECT_EQ_INT(ret, lept_parser_finish(&p, &v));
+        if (ret == LEPT_PARSE_OK) {
+            s2 = lept_stringify(&v, &n2);
+            EXPECT_EQ_SIZE_T(n1, n2);
+            EXPECT_TRUE((memcmp(s1, s2, n1) == 0));
+            free(s2);
+        }
+        else
+            EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        lept_free(&v);
+    }
+    lept_parser_free(&p);
+    free(s1);
+    lept_free(&expect);
+}
+
+//增量解析和tape解析的结果都与lept_parse_n逐一对比
+static const char* test_docs[] = {
+    "null", " true ", "false", "123", "-1.5e-10", "0", "1.7976931348623157e+308",
+    "\"\"", "\"Hello\\nWorld\"", "\"\\u0024\\u00A2\\u20AC\\uD834\\uDD1E\"", "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"",
+    "[ ]", "{ }", "[ null , false , true , 123 , \"abc\", [ 1, 2 ], {\"a\":[]} ]",
+    " { \"n\" : null , \"s\" : \"abc\" , \"a\" : [ 1, 2, 3 ] , \"o\" : { \"1\" : 1, \"2\" : 2 } } ",
+    "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16}",
+    "[[[[[[[[[[\"deep\"]]]]]]]]]]",
+    /* 错误 */
+    "", " ", "nul", "?", "nulx", "+0", ".123", "1.", "INF", "0123", "0x0", "1.2.3", "[1.2.3]", "{\"a\":0123}",
+    "1e309", "[1e309]", "\"abc", "\"\\v\"", "\"\\x12\"", "\"\x01\"", "\"\\u0G00\"", "\"\\uD800\"", "\"\\uD800\\uE000\"",
+    "[1", "[1}", "[1 2", "[[]", "[1,]", "[\"a\", nul]", "{", "{1:1,", "{\"a\"", "{\"a\" 1}", "{\"a\":",
+    "{\"a\":1", "{\"a\":1]", "{\"a\":1 \"b\"", "{\"a\":{}", "{\"a\":1,", "{\"a\":1,}", "null x", "[] []", "{\"a\":\"b"
+};
+
+static void test_parser() {
+    size_t i;
+    lept_parser p;
+    lept_value v;
+    for (i = 0; i < sizeof(test_docs) / sizeof(test_docs[0]); i++)
+        test_parser_split(test_docs[i]);
+
+    //出错之后的输入被忽略, 直到finish
+    lept_parser_init(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "[1,", 3));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_parser_feed(&p, "]", 1));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_parser_feed(&p, "2]", 2));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_parser_finish(&p, &v));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+
+    //finish之后可以解析下一个文本
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "\"ab", 3));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "c\"", 2));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_finish(&p, &v));
+    EXPECT_EQ_STRING("abc", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    //释放尚未完成的节点
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "{\"a\":[\"x\",{\"b\":\"y", 17));
+    lept_parser_free(&p);
+}
+
+//增量解析同样使用解析器的arena, 驻留池和索引设置; 解析到一半时修改设置不影响当前的文本
+static void test_parser_settings() {
+    const char* json = test_docs[15];
+    lept_parser p;
+    lept_arena a;
+    lept_intern* t = lept_intern_create(0);
+    lept_value v;
+    size_t i, len = strlen(json);
+
+    lept_arena_init(&a, 0);
+    lept_parser_init(&p);
+    lept_parser_set_arena(&p, &a);
+    lept_parser_set_intern(&p, t);
+    lept_parser_set_index(&p, 1);
+    for (i = 0; i < len; i++) {
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, json + i, 1));
+        if (i == 1)
+            lept_parser_set_index(&p, 0);
+    }
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_finish(&p, &v));
+    EXPECT_EQ_INT(LEPT_VALUE_ARENA | LEPT_VALUE_INDEXED, v.flags);
+    EXPECT_EQ_INT(LEPT_VALUE_INTERNED, v.u.o.m[0].keyFlags);
+    EXPECT_TRUE((lept_get_object_key(&v, 0) == lept_intern_n(t, "a", 1)));
+    EXPECT_EQ_DOUBLE(16.0, lept_get_number(lept_find_object_value(&v, "p", 1)));
+    //下一个文本使用修改之后的设置
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, json, len));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_finish(&p, &v));
+    EXPECT_EQ_INT(LEPT_VALUE_ARENA, v.flags);
+
+    //出错和未完成时残留的键值来自驻留池或arena, 不会被单独释放
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_parser_feed(&p, "{\"a\":{\"b\" 1", 11));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_parser_finish(&p, &v));
+    lept_parser_set_intern(&p, NULL);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "{\"a\":[{\"b\":\"y", 13));
+    lept_parser_free(&p);
+    lept_arena_free(&a);
+    lept_intern_free(t);
+}
+
+static void test_parser_parse() {
+    size_t i, size;
+    int ret;
+    lept_parser p;
+    lept_arena a;
+    lept_value v, expect;
+    char *json, *json2;
+    size_t length, length2;
+
+    //同一个解析器连续解析多个文本, 结果与lept_parse相同
+    lept_parser_init(&p);
+    for (i = 0; i < sizeof(test_docs) / sizeof(test_docs[0]); i++) {
+        lept_init(&expect);
+        ret = lept_parse(&expect, test_docs[i]);
+        EXPECT_EQ_INT(ret, lept_parser_parse(&p, &v, test_docs[i]));
+        if (ret == LEPT_PARSE_OK) {
+            json = lept_stringify(&expect, &length);
+            json2 = lept_stringify(&v, &length2);
+            EXPECT_EQ_SIZE_T(length, length2);
+            EXPECT_TRUE((memcmp(json, json2, length) == 0));
+            free(json);
+            free(json2);
+        }
+        lept_free(&expect);
+        lept_free(&v);
+    }
+    //堆栈的容量在调用之间保留下来
+    size = p.c.size;
+    EXPECT_TRUE((size > 0));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, test_docs[0]));
+    EXPECT_EQ_SIZE_T(size, p.c.size);
+    EXPECT_EQ_SIZE_T(0, p.c.top);
+    lept_free(&v);
+
+    //出错时返回与lept_parse相同的错误码, 之后可以继续使用
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parser_parse(&p, &v, "{\"a\":[\"abc\"],\"b\":1"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_parser_parse_n(&p, &v, "[1] 2", 5));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_n(&p, &v, "[1] 2", 3));
+    EXPECT_EQ_SIZE_T(1, lept_get_array_size(&v));
+    lept_free(&v);
+
+    //与增量解析交替使用
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "[\"a", 3));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_feed(&p, "b\"]", 3));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_finish(&p, &v));
+    EXPECT_EQ_STRING("ab", lept_get_string(lept_get_array_element(&v, 0)), lept_get_string_length(lept_get_array_element(&v, 0)));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, "{\"k\":\"v\"}"));
+    EXPECT_EQ_SIZE_T(1, lept_get_object_size(&v));
+    lept_free(&v);
+
+    //使用arena时, 结果从arena中分配
+    lept_arena_init(&a, 64);
+    lept_parser_set_arena(&p, &a);
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, "[\"abc\",{\"key\":\"value\"}]"));
+        EXPECT_TRUE((v.flags & LEPT_VALUE_ARENA));
+        json = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING("[\"abc\",{\"key\":\"value\"}]", json, length);
+        free(json);
+        lept_arena_reset(&a);
+    }
+    lept_parser_set_arena(&p, NULL);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, "[\"abc\"]"));
+    EXPECT_FALSE((v.flags & LEPT_VALUE_ARENA));
+    lept_free(&v);
+    lept_arena_free(&a);
+    lept_parser_free(&p);
+}
+
+//测试从一段文本中依次解析多个相连的json文本, offset指向下一个文本的开头
+static void test_parser_parse_next() {
+    const char* json = " {\"a\":1}{\"b\":[2]} [3]\n\"s\"4 true\tnull ";
+    lept_parser p;
+    lept_value v;
+    size_t offset = 0, len = strlen(json);
+
+    lept_parser_init(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(8, offset);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_SIZE_T(1, lept_get_array_size(lept_find_object_value(&v, "b", 1)));
+    //之后的空白也被跳过
+    EXPECT_EQ_SIZE_T(18, offset);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_STRING("s", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_DOUBLE(4.0, lept_get_number(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_INT(LEPT_TRUE, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, len, &offset));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(len, offset);
+
+    //出错时offset不变
+    json = "[1] [2,] [3]";
+    offset = 0;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_next(&p, &v, json, strlen(json), &offset));
+    lept_free(&v);
+    EXPECT_EQ_SIZE_T(4, offset);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_parser_parse_next(&p, &v, json, strlen(json), &offset));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(4, offset);
+    //只有空白时与lept_parse相同
+    offset = 0;
+    EXPECT_EQ_INT(LEPT_PARSE_EXCEPT_VALUE, lept_parser_parse_next(&p, &v, " ", 1, &offset));
+    EXPECT_EQ_SIZE_T(0, offset);
+    lept_parser_free(&p);
+}
+
+//测试键值驻留池: 内容相同的键值共享同一个字符串, 池满了之后解析器单独分配键值
+static void test_intern() {
+    const char* json = "[{\"id\":1,\"name\":\"a\",\"tags\":{\"id\":2}},{\"name\":\"b\",\"id\":3}]";
+    lept_intern* t = lept_intern_create(0);
+    lept_parser p;
+    lept_value v, v2;
+    const char* id;
+    const lept_value *a, *b;
+    char key[16];
+    const char* keys[1000];
+    size_t i;
+
+    //内容相同的字符串得到同一个指针
+    id = lept_intern_n(t, "id", 2);
+    EXPECT_EQ_STRING("id", id, strlen(id));
+    EXPECT_TRUE((lept_intern_n(t, "idx", 2) == id));
+    EXPECT_TRUE((lept_intern_n(t, "ID", 2) != id));
+    EXPECT_TRUE((lept_intern_n(t, "", 0) == lept_intern_n(t, "x", 0)));
+    //哈希表扩大之后指针不变
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "key%u", (unsigned)i);
+        keys[i] = lept_intern_n(t, key, strlen(key));
+    }
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "key%u", (unsigned)i);
+        if (lept_intern_n(t, key, strlen(key)) != keys[i])
+            break;
+    }
+    EXPECT_EQ_SIZE_T(1000, i);
+    EXPECT_TRUE((lept_intern_n(t, "id", 2) == id));
+
+    //多个文档的键值来自同一个池
+    lept_parser_init(&p);
+    lept_parser_set_intern(&p, t);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v2, json));
+    a = lept_get_array_element(&v, 0);
+    b = lept_get_array_element(&v2, 1);
+    EXPECT_TRUE((lept_get_object_key(a, 0) == id));
+    EXPECT_TRUE((lept_get_object_key(b, 1) == id));
+    EXPECT_TRUE((lept_get_object_key(a, 1) == lept_get_object_key(b, 0)));
+    EXPECT_EQ_INT(LEPT_VALUE_INTERNED, a->u.o.m[0].keyFlags);
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(lept_find_object_value(b, id, 2)));
+    EXPECT_EQ_DOUBLE(2.0, lept_get_number(lept_find_object_value(lept_find_object_value(a, "tags", 4), id, 2)));
+    //驻留的键值只比较指针, 池中其他内容的键值不会被找到
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(lept_find_object_value_interned(b, id, 2)));
+    EXPECT_TRUE((lept_find_object_value_interned(a, lept_intern_n(t, "name", 4), 4) == lept_get_object_value(a, 1)));
+    EXPECT_TRUE((lept_find_object_value_interned(b, lept_intern_n(t, "tags", 4), 4) == NULL));
+    lept_free(&v);
+    lept_free(&v2);
+    //解析失败时残留的键值不会被释放
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parser_parse(&p, &v, "{\"id\":{\"name\":1 ]"));
+    lept_parser_set_intern(&p, NULL);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    EXPECT_TRUE((lept_get_object_key(lept_get_array_element(&v, 0), 0) != id));
+    lept_free(&v);
+
+    //清空之后重新驻留
+    lept_intern_reset(t);
+    id = lept_intern_n(t, "id", 2);
+    EXPECT_EQ_STRING("id", id, strlen(id));
+    EXPECT_TRUE((lept_intern_n(t, "id", 2) == id));
+    lept_intern_free(t);
+
+    //每个分片只能存放1个字节, 只有空字符串能加入
+    t = lept_intern_create(1);
+    EXPECT_TRUE((lept_intern_n(t, "id", 2) == NULL));
+    EXPECT_TRUE((lept_intern_n(t, "", 0) != NULL));
+    lept_parser_set_intern(&p, t);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    a = lept_get_array_element(&v, 0);
+    EXPECT_EQ_INT(0, a->u.o.m[0].keyFlags);
+    //单独分配的键值仍然比较内容
+    EXPECT_TRUE((lept_find_object_value_interned(a, lept_intern_n(t, "", 0), 0) == NULL));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_find_object_value_interned(a, "id", 2)));
+    EXPECT_EQ_STRING("id", lept_get_object_key(a, 0), lept_get_object_key_length(a, 0));
+    lept_free(&v);
+    lept_parser_free(&p);
+    lept_intern_free(t);
+}
+
+//生成n层嵌套的数组, 或者n层嵌套的对象{"a":{"a":...1}}
+static char* make_nested(size_t n, int object) {
+    char* json = (char*)malloc(n * 6 + 2);
+    size_t i, len = 0;
+    for (i = 0; i < n; i++) {
+        if (object) {
+            memcpy(json + len, "{\"a\":", 5);
+            len += 5;
+        }
+        else
+            json[len++] = '[';
+    }
+    json[len++] = '1';
+    for (i = 0; i < n; i++)
+        json[len++] = object ? '}' : ']';
+    json[len] = '\0';
+    return json;
+}
+
+static void test_parse_depth() {
+    lept_handler handler;
+    lept_parser p;
+    lept_value v;
+    char* json;
+    int object;
+    memset(&handler, 0, sizeof(handler));
+    for (object = 0; object <= 1; object++) {
+        //最大深度以内的嵌套可以正常解析, 生成和释放
+        json = make_nested(LEPT_PARSE_MAX_DEPTH, object);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+        EXPECT_EQ_INT(object ? LEPT_OBJECT : LEPT_ARRAY, lept_get_type(&v));
+        free(lept_stringify(&v, NULL));
+        lept_free(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_sax(&handler, NULL, json, strlen(json)));
+        free(json);
+
+        json = make_nested(LEPT_PARSE_MAX_DEPTH + 1, object);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse_sax(&handler, NULL, json, strlen(json)));
+        lept_parser_init(&p);
+        EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parser_feed(&p, json, strlen(json)));
+        EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parser_finish(&p, &v));
+        lept_parser_free(&p);
+        free(json);
+    }
+
+    //不会因为调用栈溢出而崩溃
+    json = make_nested(1000000, 0);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse(&v, json));
+    free(json);
+}
+
+//比较节点树和tape中的值是否相同
+static int test_tape_equal(const lept_value* v, const lept_tape_value* t) {
+    size_t i;
+    const lept_tape_value* e;
+    if (lept_get_type(v) != lept_tape_get_type(t))
+        return 0;
+    switch (lept_get_type(v)) {
+        case LEPT_NUMBER:
+            return lept_get_number(v) == lept_tape_get_number(t);
+        case LEPT_STRING:
+            return lept_get_string_length(v) == lept_tape_get_string_length(t) &&
+                memcmp(lept_get_string(v), lept_tape_get_string(t), lept_get_string_length(v) + 1) == 0;
+        case LEPT_ARRAY:
+            if (lept_get_array_size(v) != lept_tape_get_array_size(t))
+                return 0;
+            for (i = 0; i < lept_get_array_size(v); i++) {
+                e = i == 0 ? lept_tape_get_array_element(t, 0) : lept_tape_next(e);
+                if (e != lept_tape_get_array_element(t, i) || !test_tape_equal(lept_get_array_element(v, i), e))
+                    return 0;
+            }
+            return lept_tape_next(t) == (i == 0 ? t + 2 : lept_tape_next(e));
+        case LEPT_OBJECT:
+            if (lept_get_object_size(v) != lept_tape_get_object_size(t))
+                return 0;
+            for (i = 0; i < lept_get_object_size(v); i++) {
+                if (lept_get_object_key_length(v, i) != lept_tape_get_object_key_length(t, i) ||
+                    memcmp(lept_get_object_key(v, i), lept_tape_get_object_key(t, i), lept_get_object_key_length(v, i) + 1) != 0 ||
+                    !test_tape_equal(lept_get_object_value(v, i), lept_tape_get_object_value(t, i)))
+                    return 0;
+            }
+            return 1;
+        default:
+            return 1;
+    }
+}
+
+static void test_parse_tape() {
+    lept_tape t;
+    lept_value v;
+    const lept_tape_value* root;
+    const lept_tape_value* e;
+    char* json;
+    size_t i;
+    int ret;
+    for (i = 0; i < sizeof(test_docs) / sizeof(test_docs[0]); i++) {
+        lept_init(&v);
+        ret = lept_parse_n(&v, test_docs[i], strlen(test_docs[i]));
+        EXPECT_EQ_INT(ret, lept_parse_tape(&t, test_docs[i], strlen(test_docs[i])));
+        if (ret == LEPT_PARSE_OK) {
+            EXPECT_TRUE(test_tape_equal(&v, lept_tape_root(&t)));
+            EXPECT_TRUE((lept_tape_next(lept_tape_root(&t)) == t.words + t.size));
+        }
+        else
+            EXPECT_TRUE((t.words == NULL));
+        lept_tape_free(&t);
+        lept_free(&v);
+    }
+
+    json = "{\"n\":null,\"t\":true,\"f\":false,\"x\":-1.5,\"s\":\"a\\u0000b\",\"12345678\":[[],{},\"\"],\"o\":{\"k\":1}}";
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_tape(&t, json, strlen(json)));
+    root = lept_tape_root(&t);
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_tape_get_type(root));
+    EXPECT_EQ_SIZE_T(7, lept_tape_get_object_size(root));
+    EXPECT_EQ_INT(LEPT_NULL, lept_tape_get_type(lept_tape_find_object_value(root, "n", 1)));
+    EXPECT_TRUE(lept_tape_get_boolean(lept_tape_find_object_value(root, "t", 1)));
+    EXPECT_FALSE(lept_tape_get_boolean(lept_tape_find_object_value(root, "f", 1)));
+    EXPECT_EQ_DOUBLE(-1.5, lept_tape_get_number(lept_tape_find_object_value(root, "x", 1)));
+    e = lept_tape_find_object_value(root, "s", 1);
+    EXPECT_EQ_STRING("a\0b", lept_tape_get_string(e), lept_tape_get_string_length(e));
+    EXPECT_EQ_STRING("12345678", lept_tape_get_object_key(root, 5), lept_tape_get_object_key_length(root, 5));
+    e = lept_tape_get_object_value(root, 5);
+    EXPECT_EQ_SIZE_T(3, lept_tape_get_array_size(e));
+    EXPECT_EQ_SIZE_T(0, lept_tape_get_array_size(lept_tape_get_array_element(e, 0)));
+    EXPECT_EQ_SIZE_T(0, lept_tape_get_object_size(lept_tape_get_array_element(e, 1)));
+    EXPECT_EQ_SIZE_T(0, lept_tape_get_string_length(lept_tape_get_array_element(e, 2)));
+    //跳过整个数组之后是下一个成员的键值
+    EXPECT_EQ_STRING("o", lept_tape_get_string(lept_tape_next(e)), 1);
+    e = lept_tape_find_object_value(root, "o", 1);
+    EXPECT_EQ_DOUBLE(1.0, lept_tape_get_number(lept_tape_find_object_value(e, "k", 1)));
+    EXPECT_TRUE((lept_tape_find_object_value(root, "k", 1) == NULL));
+    lept_tape_free(&t);
+
+    json = make_nested(LEPT_PARSE_MAX_DEPTH + 1, 0);
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse_tape(&t, json, strlen(json)));
+    free(json);
+}
+
+static void test_parse_lazy() {
+    lept_value v, expect;
+    lept_value* e;
+    const char* json = " { \"a\" : [ 1, { \"b\" : [ \"]\\\"[\" ] } ], \"c\" : { \"d\" : \"x\" }, \"e\" : [] } ";
+    char *json1, *json2;
+    size_t length1, length2;
+    size_t i;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_lazy(&v, json, strlen(json)));
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&v));
+    //根节点这一层已经展开, 内层的容器只记录了文本范围
+    e = &v.u.o.m[0].v;
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(e));
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, e->flags);
+    EXPECT_TRUE((e->u.l.json == strchr(json, '[')));
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, v.u.o.m[1].v.flags);
+    //访问之前用lept_expand展开一层
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_expand(e));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(e));
+    EXPECT_FALSE((e->flags & LEPT_VALUE_LAZY));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_get_array_element(e, 0)));
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, lept_get_array_element(e, 1)->flags);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_expand(lept_get_array_element(e, 1)));
+    e = lept_find_object_value(lept_get_array_element(e, 1), "b", 1);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_expand(e));
+    EXPECT_EQ_STRING("]\"[", lept_get_string(lept_get_array_element(e, 0)), lept_get_string_length(lept_get_array_element(e, 0)));
+    //生成时临时解析剩余的容器, 结果与完整解析相同, 节点本身不被修改
+    lept_init(&expect);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&expect, json));
+    json1 = lept_stringify(&expect, &length1);
+    json2 = lept_stringify(&v, &length2);
+    EXPECT_EQ_SIZE_T(length1, length2);
+    EXPECT_TRUE((memcmp(json1, json2, length1) == 0));
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, v.u.o.m[1].v.flags);
+    free(json1);
+    free(json2);
+    lept_free(&expect);
+    lept_free(&v);
+
+    //未展开的容器可以直接释放
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_lazy(&v, json, strlen(json)));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+
+    //内层容器的语法错误在展开时才报告, 出错的节点保持未展开, 生成时同样报告错误
+    json = "[[1,2,],{\"a\"}]";
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_lazy(&v, json, strlen(json)));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_expand(lept_get_array_element(&v, 0)));
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, lept_get_array_element(&v, 0)->flags);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_ARRAY_ELEMENT, lept_expand(lept_get_array_element(&v, 0)));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_expand(lept_get_array_element(&v, 1)));
+    EXPECT_TRUE((lept_stringify(&v, &length1) == NULL));
+    EXPECT_EQ_SIZE_T(0, length1);
+    lept_free(&v);
+
+    //括号不配对, 字符串没有结束
+    {
+        static const char* errors[] = { "[[1,2]", "{\"a\":{\"b\":1}", "[[\"]]", "{\"a\":[\"\\\"]}" };
+        static const int codes[] = { LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+            LEPT_PARSE_MISS_QUOTATION_MARK, LEPT_PARSE_MISS_QUOTATION_MARK };
+        for (i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+            lept_init(&v);
+            EXPECT_EQ_INT(codes[i], lept_parse_lazy(&v, errors[i], strlen(errors[i])));
+            EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        }
+    }
+
+    //有效的文本与完整解析的结果相同
+    for (i = 0; i < sizeof(test_docs) / sizeof(test_docs[0]); i++) {
+        lept_init(&v);
+        lept_init(&expect);
+        if (lept_parse_n(&expect, test_docs[i], strlen(test_docs[i])) == LEPT_PARSE_OK) {
+            EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_lazy(&v, test_docs[i], strlen(test_docs[i])));
+            json1 = lept_stringify(&expect, &length1);
+            json2 = lept_stringify(&v, &length2);
+            EXPECT_EQ_SIZE_T(length1, length2);
+            EXPECT_TRUE((memcmp(json1, json2, length1) == 0));
+            free(json1);
+            free(json2);
+        }
+        lept_free(&expect);
+        lept_free(&v);
+    }
+}
+
+#define TEST_POINTER(expect, path) \
+    do {\
+        lept_pointer* p = lept_pointer_compile(path);\
+        lept_value* e;\
+        char* json;\
+        size_t length;\
+        EXPECT_TRUE((p != NULL));\
+        e = lept_pointer_get(&v, p);\
+        EXPECT_TRUE((e != NULL));\
+        json = lept_stringify(e, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        free(json);\
+        lept_pointer_free(p);\
+    } while(0)
+
+static void test_pointer() {
+    //RFC 6901中的例子
+    const char* json = "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}";
+    static const char* missing[] = { "/foo/2", "/foo/-", "/foo/01", "/foo/0/x", "/bar", "/a~1b/0" };
+    lept_value v, e;
+    lept_pointer* p;
+    size_t i;
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    TEST_POINTER("[\"bar\",\"baz\"]", "/foo");
+    TEST_POINTER("\"bar\"", "/foo/0");
+    TEST_POINTER("0", "/");
+    TEST_POINTER("1", "/a~1b");
+    TEST_POINTER("2", "/c%d");
+    TEST_POINTER("3", "/e^f");
+    TEST_POINTER("4", "/g|h");
+    TEST_POINTER("5", "/i\\j");
+    TEST_POINTER("6", "/k\"l");
+    TEST_POINTER("7", "/ ");
+    TEST_POINTER("8", "/m~0n");
+    p = lept_pointer_compile("");
+    EXPECT_TRUE((lept_pointer_get(&v, p) == &v));
+    lept_pointer_free(p);
+    for (i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+        p = lept_pointer_compile(missing[i]);
+        EXPECT_TRUE((lept_pointer_get(&v, p) == NULL));
+        lept_init(&e);
+        EXPECT_EQ_INT(LEPT_PARSE_NOT_FOUND, lept_pointer_parse(&e, json, strlen(json), p));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&e));
+        lept_pointer_free(p);
+    }
+    lept_free(&v);
+
+    //格式错误的路径
+    EXPECT_TRUE((lept_pointer_compile("a") == NULL));
+    EXPECT_TRUE((lept_pointer_compile("/~") == NULL));
+    EXPECT_TRUE((lept_pointer_compile("/a~2") == NULL));
+
+    //有哈希索引的对象
+    json = "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,"
+        "\"p\":[{\"x\":[true]},{\"y\":\"z\"}],\"q\":[1,2]}";
+    {
+        lept_parser parser;
+        lept_parser_init(&parser);
+        lept_parser_set_index(&parser, 1);
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&parser, &v, json));
+        EXPECT_EQ_INT(LEPT_VALUE_INDEXED, v.flags);
+        TEST_POINTER("\"z\"", "/p/1/y");
+        TEST_POINTER("15", "/o");
+        lept_free(&v);
+        lept_parser_free(&parser);
+    }
+
+    //惰性解析的文本需要先展开路径上的容器, 路径经过未展开的容器时得到NULL
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_lazy(&v, json, strlen(json)));
+    TEST_POINTER("15", "/o");
+    p = lept_pointer_compile("/p/1/y");
+    EXPECT_TRUE((lept_pointer_get(&v, p) == NULL));
+    lept_pointer_free(p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_expand(lept_find_object_value(&v, "p", 1)));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_expand(lept_get_array_element(lept_find_object_value(&v, "p", 1), 1)));
+    TEST_POINTER("\"z\"", "/p/1/y");
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, lept_find_object_value(&v, "q", 1)->flags);
+    EXPECT_EQ_INT(LEPT_VALUE_LAZY, lept_get_array_element(lept_find_object_value(&v, "p", 1), 0)->flags);
+    lept_free(&v);
+
+    //直接在文本中查找, 找到之后不再读取剩余的文本
+    p = lept_pointer_compile("/p/0");
+    lept_init(&e);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_pointer_parse(&e, json, strlen(json), p));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&e));
+    EXPECT_TRUE(lept_get_boolean(lept_get_array_element(lept_find_object_value(&e, "x", 1), 0)));
+    lept_free(&e);
+    lept_pointer_free(p);
+    p = lept_pointer_compile("/1/0");
+    json = "[{\"a\":\"\\n\"},[1,{\"b\":\"x\"}],2] garbage";
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_pointer_parse(&e, json, strlen(json), p));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(&e));
+    lept_free(&e);
+    lept_pointer_free(p);
+    p = lept_pointer_compile("/p/0");
+    //目标之前的错误仍然被报告
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_pointer_parse(&e, "{\"a\":1 \"p\":[0]}", 15, p));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_pointer_parse(&e, "{\"p\" [0]}", 9, p));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, lept_pointer_parse(&e, "{\"a\":[\"]}", 9, p));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_pointer_parse(&e, "{\"p\":[nul]}", 11, p));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&e));
+    lept_pointer_free(p);
+}
+
+static void test_parse_select() {
+    static const char* paths[] = { "/user/name", "/ids/2", "/user", "/missing", "/user/tags/1", "/ids/-" };
+    const char* json = "{\"id\":1,\"text\":\"x\\ty\",\"ids\":[10,[11],12,13],\"user\":{\"tags\":[\"a\",\"b\"],\"name\":\"lept\"},\"n\":null}";
+    lept_pointer* p[6];
+    lept_value values[6];
+    char* json2;
+    size_t length, i;
+    for (i = 0; i < 6; i++)
+        p[i] = lept_pointer_compile(paths[i]);
+
+    EXPECT_EQ_INT(LEPT_PARSE_NOT_FOUND, lept_parse_select(json, strlen(json), (const lept_pointer* const*)p, 6, values, 0));
+    EXPECT_EQ_STRING("lept", lept_get_string(&values[0]), lept_get_string_length(&values[0]));
+    EXPECT_EQ_DOUBLE(12.0, lept_get_number(&values[1]));
+    json2 = lept_stringify(&values[2], &length);
+    EXPECT_EQ_STRING("{\"tags\":[\"a\",\"b\"],\"name\":\"lept\"}", json2, length);
+    free(json2);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&values[3]));
+    EXPECT_TRUE((values[3].flags & LEPT_VALUE_MISSING));
+    EXPECT_EQ_STRING("b", lept_get_string(&values[4]), lept_get_string_length(&values[4]));
+    EXPECT_TRUE((values[5].flags & LEPT_VALUE_MISSING));
+    EXPECT_FALSE((values[0].flags & LEPT_VALUE_MISSING));
+    for (i = 0; i < 6; i++)
+        lept_free(&values[i]);
+
+    //全部找到之后不再读取剩余的文本, 除非要求完整校验
+    json = "{\"ids\":[1,2,3],\"user\":{\"tags\":[0,\"t\"],\"name\":\"n\"},\"rest\":[1,}";
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_select(json, strlen(json), (const lept_pointer* const*)p, 2, values, 0));
+    EXPECT_EQ_STRING("n", lept_get_string(&values[0]), lept_get_string_length(&values[0]));
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(&values[1]));
+    lept_free(&values[0]);
+    lept_free(&values[1]);
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_parse_select(json, strlen(json), (const lept_pointer* const*)p, 2, values, LEPT_SELECT_VALIDATE));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&values[0]));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&values[1]));
+
+    //跳过的部分只检查括号配对, 完整校验时报告其中的错误
+    json = "{\"x\":[tru],\"ids\":[0,0,7]}";
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_select(json, strlen(json), (const lept_pointer* const*)&p[1], 1, values, 0));
+    EXPECT_EQ_DOUBLE(7.0, lept_get_number(&values[0]));
+    lept_free(&values[0]);
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_parse_select(json, strlen(json), (const lept_pointer* const*)&p[1], 1, values, LEPT_SELECT_VALIDATE));
+
+    //与lept_pointer_get一样, 重复的键值只查找第一个成员
+    json = "{\"user\":{\"tags\":[]},\"user\":{\"name\":\"x\"}}";
+    EXPECT_EQ_INT(LEPT_PARSE_NOT_FOUND, lept_parse_select(json, strlen(json), (const lept_pointer* const*)p, 1, values, 0));
+    EXPECT_TRUE((values[0].flags & LEPT_VALUE_MISSING));
+
+    //与完整解析的错误码相同
+    for (i = 0; i < sizeof(test_docs) / sizeof(test_docs[0]); i++) {
+        lept_value v;
+        int ret;
+        lept_init(&v);
+        ret = lept_parse_n(&v, test_docs[i], strlen(test_docs[i]));
+        lept_free(&v);
+        EXPECT_EQ_INT(ret, lept_parse_select(test_docs[i], strlen(test_docs[i]), NULL, 0, NULL, LEPT_SELECT_VALIDATE));
+    }
+    for (i = 0; i < 6; i++)
+        lept_pointer_free(p[i]);
+}
+
 static void test_stringify_number() {
     TEST_ROUNDTRIP("0");
     TEST_ROUNDTRIP("-0");
@@ -354,14 +1445,30 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1.234e-20");
 
     TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+    //输出能够还原的最短数字, 而不是固定的17位有效数字
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.30000000000000004");
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1e-05");
+    TEST_ROUNDTRIP("10000000000000000");
+    TEST_ROUNDTRIP("1e+17");
+    TEST_ROUNDTRIP("1.2345678901234568e+20");
+    TEST_ROUNDTRIP("9007199254740992");
+    TEST_ROUNDTRIP("-123.456");
+    //Grisu3无法确定的情况由大整数精确计算, 仍然是最短的数字
+    TEST_ROUNDTRIP("1e+23");
+    TEST_ROUNDTRIP("2.9909711192291e+136");
+    TEST_ROUNDTRIP("5e-310");
+    TEST_ROUNDTRIP("9.5e-322");
 }
 
 static void test_stringify_string() {
@@ -370,6 +1477,44 @@ static void test_stringify_string() {
     TEST_ROUNDTRIP("\"Hello\\nWorld\"");
     TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
     TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_ROUNDTRIP("\"\\u0001\\u001F\\n\\\"abc\"");
+}
+
+//长字符串中需要转义的字符出现在不同的位置(跨越向量的边界), 输出必须与逐字节转义的结果相同
+static void test_stringify_long_string() {
+    static const char specials[] = { '"', '\\', '\n', '\x01', '\x1F', '\x7F', 'a' };
+    char s[100], expect[700];
+    size_t pos, k, i, n, len;
+    for (k = 0; k < sizeof(specials); k++) {
+        for (pos = 0; pos < sizeof(s); pos++) {
+            lept_value v;
+            char* json;
+            for (i = 0; i < sizeof(s); i++)
+                s[i] = (char)('A' + i % 26);
+            s[pos] = specials[k];
+            //最后一个位置之后再放一串连续的转义字符
+            if (pos + 3 < sizeof(s))
+                s[pos + 1] = s[pos + 2] = '\t';
+            n = 0;
+            expect[n++] = '"';
+            for (i = 0; i < sizeof(s); i++) {
+                unsigned char ch = (unsigned char)s[i];
+                if (ch == '"' || ch == '\\') { expect[n++] = '\\'; expect[n++] = (char)ch; }
+                else if (ch == '\n') { expect[n++] = '\\'; expect[n++] = 'n'; }
+                else if (ch == '\t') { expect[n++] = '\\'; expect[n++] = 't'; }
+                else if (ch < 0x20) n += sprintf(expect + n, "\\u%04X", ch);
+                else expect[n++] = (char)ch;
+            }
+            expect[n++] = '"';
+            lept_init(&v);
+            lept_set_string(&v, s, sizeof(s));
+            json = lept_stringify(&v, &len);
+            EXPECT_EQ_SIZE_T(n, len);
+            EXPECT_TRUE((memcmp(expect, json, n) == 0));
+            free(json);
+            lept_free(&v);
+        }
+    }
 }
 
 static void test_stringify_array() {
@@ -382,14 +1527,143 @@ static void test_stringify_object() {
     TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
 }
 
+//测试用的writer: 把收到的片段拼接起来, 收到fail_at个片段之后返回失败
+typedef struct {
+    char* data;
+    size_t len;
+    int calls;
+    int fail_at;
+} test_writer_ctx;
+
+static int test_writer(void* ctx, const char* data, size_t len) {
+    test_writer_ctx* w = (test_writer_ctx*)ctx;
+    w->data = (char*)realloc(w->data, w->len + len);
+    memcpy(w->data + w->len, data, len);
+    w->len += len;
+    return ++w->calls != w->fail_at;
+}
+
+static void test_stringify_to() {
+    lept_value v;
+    test_writer_ctx w = { NULL, 0, 0, 0 };
+    char* json;
+    size_t len, i;
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":[1,2.5,\"x\\ny\"],\"b\":null}"));
+    EXPECT_EQ_INT(LEPT_STRINGIFY_OK, lept_stringify_to(&v, test_writer, &w));
+    EXPECT_EQ_STRING("{\"a\":[1,2.5,\"x\\ny\"],\"b\":null}", w.data, w.len);
+    EXPECT_EQ_INT(1, w.calls);
+    lept_free(&v);
+
+    //输出超过缓冲区大小时分多次交给writer, 拼接后与lept_stringify的结果相同
+    lept_init(&v);
+    json = (char*)malloc(100000 * 8 + 2);
+    len = 0;
+    json[len++] = '[';
+    for (i = 0; i < 100000; i++)
+        len += sprintf(json + len, i ? ",\"%04d\"" : "\"%04d\"", (int)(i % 10000));
+    json[len++] = ']';
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, json, len));
+    free(json);
+    json = lept_stringify(&v, &len);
+    free(w.data);
+    w.data = NULL;
+    w.len = 0;
+    w.calls = 0;
+    EXPECT_EQ_INT(LEPT_STRINGIFY_OK, lept_stringify_to(&v, test_writer, &w));
+    EXPECT_EQ_SIZE_T(len, w.len);
+    EXPECT_TRUE((memcmp(json, w.data, len) == 0));
+    EXPECT_TRUE((w.calls > 1));
+
+    //比输出缓冲区更长的字符串直接交给writer
+    {
+        lept_value s;
+        char* big = (char*)malloc(20000);
+        char* json2;
+        size_t len2;
+        memset(big, 'x', 20000);
+        big[5000] = '\n';
+        lept_init(&s);
+        lept_set_string(&s, big, 20000);
+        json2 = lept_stringify(&s, &len2);
+        free(w.data);
+        w.data = NULL;
+        w.len = 0;
+        w.calls = 0;
+        EXPECT_EQ_INT(LEPT_STRINGIFY_OK, lept_stringify_to(&s, test_writer, &w));
+        EXPECT_EQ_SIZE_T(len2, w.len);
+        EXPECT_TRUE((memcmp(json2, w.data, len2) == 0));
+        free(json2);
+        free(big);
+        lept_free(&s);
+    }
+
+    //writer失败之后不再被调用
+    free(w.data);
+    w.data = NULL;
+    w.len = 0;
+    w.calls = 0;
+    w.fail_at = 2;
+    EXPECT_EQ_INT(LEPT_STRINGIFY_WRITE_ERROR, lept_stringify_to(&v, test_writer, &w));
+    EXPECT_EQ_INT(2, w.calls);
+    free(w.data);
+    free(json);
+    lept_free(&v);
+}
+
+//手工构造超过解析深度限制的嵌套, 生成和释放都不会因为调用栈溢出而崩溃
+static void test_stringify_deep() {
+    const size_t n = 100000;
+    lept_value v, child;
+    char* json;
+    size_t i, len;
+    int ok = 1;
+    lept_init(&v);
+    lept_set_number(&v, 1.0);
+    //由内向外构造, 数组和对象{"a":...}交替出现
+    for (i = 0; i < n; i++) {
+        child = v;
+        if (i % 2 == 0) {
+            v.type = LEPT_ARRAY;
+            v.u.a.e = (lept_value*)malloc(sizeof(lept_value));
+            v.u.a.e[0] = child;
+            v.u.a.size = 1;
+        }
+        else {
+            v.type = LEPT_OBJECT;
+            v.u.o.m = (lept_member*)malloc(sizeof(lept_member));
+            v.u.o.m[0].key = (char*)malloc(2);
+            memcpy(v.u.o.m[0].key, "a", 2);
+            v.u.o.m[0].keyLen = 1;
+            v.u.o.m[0].keyFlags = 0;
+            v.u.o.m[0].v = child;
+            v.u.o.size = 1;
+        }
+        v.flags = 0;
+    }
+    json = lept_stringify(&v, &len);
+    EXPECT_EQ_SIZE_T(n / 2 * 6 + n / 2 * 2 + 1, len);
+    for (i = 0; i < n / 2; i++)
+        if (memcmp(json + i * 6, "{\"a\":[", 6) != 0 || memcmp(json + n / 2 * 6 + 1 + i * 2, "]}", 2) != 0)
+            ok = 0;
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE((json[n / 2 * 6] == '1'));
+    free(json);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
 static void test_stringify() {
     TEST_ROUNDTRIP("null");
     TEST_ROUNDTRIP("false");
     TEST_ROUNDTRIP("true");
     test_stringify_number();
     test_stringify_string();
+    test_stringify_long_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_to();
+    test_stringify_deep();
 }
 
 
@@ -402,11 +1676,13 @@ static void test_parse(){
 
     //测试能否正确解析json中的数字字符
     test_parse_number();
+    test_parse_number_exact();
     test_parse_number_too_big();
 
     //测试能否正确get和set, json中的字符串
     //测试解析json字符串
     test_parse_string();
+    test_parse_long_string();
 
     test_parse_array();
 
@@ -423,10 +1699,26 @@ static void test_parse(){
 
 
     test_parse_object();
+    test_find_object();
     //解析对象时可能产生的错误码测试
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+
+    test_parse_arena();
+    test_parse_view();
+    test_parse_n();
+    test_parse_sax();
+    test_parser();
+    test_parser_settings();
+    test_parser_parse();
+    test_parser_parse_next();
+    test_intern();
+    test_parse_depth();
+    test_parse_tape();
+    test_parse_lazy();
+    test_pointer();
+    test_parse_select();
 }
 
 
@@ -482,87 +1774,278 @@ static void test_access_string(){
     lept_free(&v);
 }
 
+static void test_access_inline_string(){
+    const char* json = "[\"\",\"14 characters.\",\"15 characters..\",\"escaped\\n\\u00e9\"]";
+    lept_value v;
+    lept_value* e;
+    char* json2;
+    size_t length;
+
+    //不超过14个字符(64位平台)的字符串存放在节点中
+    lept_init(&v);
+    lept_set_string(&v, "Hello World!!!", 14);
+    EXPECT_EQ_STRING("Hello World!!!", lept_get_string(&v), lept_get_string_length(&v));
+    EXPECT_EQ_INT(sizeof(void*) == 8 ? LEPT_VALUE_INLINE : 0, v.flags);
+    EXPECT_EQ_INT('\0', lept_get_string(&v)[14]);
+    lept_set_string(&v, "Hello World!!!!", 15);
+    EXPECT_EQ_STRING("Hello World!!!!", lept_get_string(&v), lept_get_string_length(&v));
+    EXPECT_EQ_INT(0, v.flags);
+    lept_set_string(&v, "ok", 2);
+    EXPECT_EQ_STRING("ok", lept_get_string(&v), lept_get_string_length(&v));
+    EXPECT_EQ_INT(LEPT_VALUE_INLINE, v.flags);
+    lept_free(&v);
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    e = lept_get_array_element(&v, 0);
+    EXPECT_EQ_STRING("", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_EQ_INT(LEPT_VALUE_INLINE, e->flags);
+    e = lept_get_array_element(&v, 1);
+    EXPECT_EQ_STRING("14 characters.", lept_get_string(e), lept_get_string_length(e));
+    e = lept_get_array_element(&v, 2);
+    EXPECT_EQ_STRING("15 characters..", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_EQ_INT(0, e->flags);
+    e = lept_get_array_element(&v, 3);
+    EXPECT_EQ_STRING("escaped\n\xC3\xA9", lept_get_string(e), lept_get_string_length(e));
+    json2 = lept_stringify(&v, &length);
+    EXPECT_EQ_STRING("[\"\",\"14 characters.\",\"15 characters..\",\"escaped\\n\xC3\xA9\"]", json2, length);
+    free(json2);
+    lept_free(&v);
+}
+
 static void test_access(){
     test_access_boolean();
     test_access_number();
     test_access_string();
+    test_access_inline_string();
     test_access_null();
 }
 
-static int parse_file(const char* filename, const char* mode){
-    FILE* fp = NULL;
-    FILE* fp2 = NULL;
-    errno_t err;
-    char buff[1024];
-    char buffer[4096];
+//把json文本写入临时文件, 然后通过lept_parse_file解析
+static int parse_file(lept_value* v, const char* filename, const char* json, size_t len){
+    int ret;
+    FILE* fp = fopen(filename, "wb");
+    if(!fp){
+        printf("create test json file is faild\n");
+        return LEPT_PARSE_FILE_ERROR;
+    }
+    fwrite(json, 1, len, fp);
+    fclose(fp);
+    ret = lept_parse_file(v, filename);
+    remove(filename);
+    return ret;
+}
+
+static void test_parse_file(){
+    const char* filename = "leptjson_test_file.json";
+    const char* json = "{\"n\":null,\"s\":\"abc\",\"a\":[1,2,3]}";
     lept_value v;
+    char* big;
+    size_t i, n;
+
     lept_init(&v);
-    size_t object_size;
-    int ret;
-    int size;
-    char* read_str ;
-    char* new_str = NULL;
-    size_t str_length = 0;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, parse_file(&v, filename, json, strlen(json)));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&v));
+    EXPECT_EQ_STRING("abc", lept_get_string(lept_get_object_value(&v, 1)), lept_get_string_length(lept_get_object_value(&v, 1)));
+    lept_free(&v);
+
+    //文件大小不再受到固定缓冲区的限制
+    n = 100000;
+    big = (char*)malloc(n * 2 + 2);
+    big[0] = '[';
+    for(i = 0; i < n; i++){
+        big[1 + i * 2] = '0' + i % 10;
+        big[2 + i * 2] = ',';
+    }
+    big[n * 2] = ']';
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, parse_file(&v, filename, big, n * 2 + 1));
+    EXPECT_EQ_SIZE_T(n, lept_get_array_size(&v));
+    EXPECT_EQ_DOUBLE(9.0, lept_get_number(lept_get_array_element(&v, n - 1)));
+    lept_free(&v);
+    free(big);
 
-    err = fopen_s(&fp, filename, mode);
-    if(err == 0){
-        printf("The file was opened\n");
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_EXCEPT_VALUE, parse_file(&v, filename, "", 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, parse_file(&v, filename, "\"abc", 4));
+    EXPECT_EQ_INT(LEPT_PARSE_FILE_ERROR, lept_parse_file(&v, "leptjson_no_such_file.json"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
 
-        while(1){
-            fgets(buff, sizeof(buff), fp);
-            
-            // strcat(buffer, buff); //可能在使用时产生溢出
+//用lept_parse_n和lept_parse_parallel分别解析, 比较返回值和生成的文本
+static void test_parallel_equal(const char* json, size_t len, size_t threads){
+    lept_value expect, v;
+    char *json1, *json2;
+    size_t length1, length2;
+    int ret = lept_parse_n(&expect, json, len);
+    EXPECT_EQ_INT(ret, lept_parse_parallel(&v, json, len, threads));
+    if (ret == LEPT_PARSE_OK) {
+        json1 = lept_stringify(&expect, &length1);
+        json2 = lept_stringify(&v, &length2);
+        EXPECT_EQ_SIZE_T(length1, length2);
+        EXPECT_TRUE((memcmp(json1, json2, length1) == 0));
+        free(json1);
+        free(json2);
+    }
+    lept_free(&expect);
+    lept_free(&v);
+}
 
-            strcat_s(buffer, sizeof(buffer), buff); //如果产生溢出时会抛出异常;
+static void test_parse_parallel(){
+    //字符串t取下面这个文本的不同长度的前缀, 每个前缀都是合法的字符串内容
+    static const int cut[] = { 0, 2, 5, 9, 13, 17, 21, 27 };
+    lept_value v;
+    char* big;
+    size_t i, n, len, threads;
 
-            if(feof(fp))//到文件结尾跳出循环
-                break;
-        }
-        printf("Content : %s\n length: %zu\n",  buffer, strlen(buffer)+1);
-
-
-        ret = lept_parse(&v, buffer);
-        if( ret == LEPT_PARSE_OK){
-            if(lept_get_type(&v) == LEPT_OBJECT){
-                object_size = lept_get_object_size(&v);
-                printf(" Have Json Object : %zu\n", object_size);
-
-                new_str = lept_stringify(&v, &str_length);
-                if(!new_str){
-                    printf("stringify is faild\n");
-                    return -1;
-                }
-                fp2 = fopen("C:\\Users\\EL_Valley\\Desktop\\newJson.json", "w");
-                if(!fp2){
-                    printf("create new json file is faild\n");
-                    return -1;
-                }
-                fprintf(fp2, "%s", new_str);
-                fclose(fp2);
+    //小文档直接使用lept_parse_n
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_parallel(&v, "[1,[2],\"3\"]", 11, 4));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(&v));
+    lept_free(&v);
 
-            }
+    //超过LEPT_PARALLEL_MIN_CHUNK的两倍时分段建立索引; 字符串中的括号, 逗号和转义的引号不是结构字符
+    n = 40000;
+    big = (char*)malloc(n * 128 + 16);
+    len = sprintf(big, " [");
+    for (i = 0; i < n; i++)
+        len += sprintf(big + len, "%s{\"id\":%u,\"s\":\"a\\\"],{\\\\\",\"a\":[[%u],{\"b\":null}],\"t\":\"%.*s\"}",
+            i ? "," : "", (unsigned)i, (unsigned)i, cut[i % 8], "\\\\\\\"[]{},::\\\\\\\\\\\"\\\"x[]{},\\\\");
+    len += sprintf(big + len, "]\n");
+    for (threads = 1; threads <= 8; threads *= 2)
+        test_parallel_equal(big, len, threads);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_parallel(&v, big, len, 4));
+    EXPECT_EQ_SIZE_T(n, lept_get_array_size(&v));
+    EXPECT_EQ_DOUBLE(n - 1.0, lept_get_number(lept_find_object_value(lept_get_array_element(&v, n - 1), "id", 2)));
+    lept_free(&v);
 
-        
+    //出错时与lept_parse_n的错误码相同
+    big[len - 2] = '}';
+    test_parallel_equal(big, len, 4);
+    big[len - 2] = ']';
+    big[len - 1] = '1';
+    test_parallel_equal(big, len, 4);
+    big[len - 1] = '\n';
+    big[len / 2] = '\"';
+    test_parallel_equal(big, len, 4);
+    big[len / 2 + 1] = ',';
+    test_parallel_equal(big, len, 4);
+
+    //根节点是对象时直接使用lept_parse_n
+    big[1] = '{';
+    test_parallel_equal(big, len, 4);
+    free(big);
+}
 
-            lept_free(&v);
-            return 10;
+//记录每条记录的回调: 序号互不相同, 多个线程写入不同的位置
+typedef struct{
+    double* numbers;
+    int* errors;
+    size_t stop_at;
+}ndjson_result;
+
+static int ndjson_record(void* ctx, size_t index, lept_value* v, int error){
+    ndjson_result* r = (ndjson_result*)ctx;
+    r->errors[index] = error;
+    if (error == LEPT_PARSE_OK)
+        r->numbers[index] = lept_get_number(lept_get_array_element(v, 0));
+    return index != r->stop_at;
+}
 
-        }
-        else{
-            printf("Parse is faild number: %d\n", ret);
-        }
-    
-        fclose(fp);
+static void test_parse_ndjson(){
+    const char* json = "{\"a\":1}\n\n[1,\"x\"]\r\n \t \n\"abc\"";
+    const char* filename = "leptjson_test_file.ndjson";
+    lept_value v;
+    ndjson_result r;
+    char* big;
+    size_t i, n, len;
+    FILE* fp;
+
+    //空行被跳过, 记录按原来的顺序存入数组
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ndjson(&v, json, strlen(json), 0));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(&v));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(lept_get_array_element(&v, 0)));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(lept_get_array_element(&v, 1)));
+    EXPECT_EQ_STRING("abc", lept_get_string(lept_get_array_element(&v, 2)), lept_get_string_length(lept_get_array_element(&v, 2)));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ndjson(&v, "\n \n", 3, 0));
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&v));
+    lept_free(&v);
+    //一行中只能有一个json文本
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_parse_ndjson(&v, "1\n2 3\n4", 7, 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parse_ndjson(&v, "[1\n]", 4, 0));
+
+    //足够大的文本分给多个线程, 结果与线程数无关
+    n = 100000;
+    big = (char*)malloc(n * 16);
+    for (i = 0, len = 0; i < n; i++)
+        len += sprintf(big + len, "[%u,\"r\"]\n", (unsigned)i);
+    for (i = 1; i <= 8; i *= 2) {
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ndjson(&v, big, len, i));
+        EXPECT_EQ_SIZE_T(n, lept_get_array_size(&v));
+        EXPECT_EQ_DOUBLE(0.0, lept_get_number(lept_get_array_element(lept_get_array_element(&v, 0), 0)));
+        EXPECT_EQ_DOUBLE(n - 1.0, lept_get_number(lept_get_array_element(lept_get_array_element(&v, n - 1), 0)));
+        lept_free(&v);
     }
-    else
-        printf("Open the file was failed\n");
-    
-    return -1;
-}
 
-static int test_parse_file(){
-    
-    return parse_file("C:\\Users\\EL_Valley\\Desktop\\testJson_1.json", "r+");
+    //返回序号最小的出错记录的错误码
+    strchr(big + len / 2, '\n')[1] = '{';
+    strchr(big + len - len / 8, '\n')[-1] = '}';
+    for (i = 1; i <= 8; i *= 2)
+        EXPECT_EQ_INT(LEPT_PARSE_MISS_KEY, lept_parse_ndjson(&v, big, len, i));
+
+    //逐条回调, 出错的记录不影响其他记录
+    r.numbers = (double*)malloc(n * sizeof(double));
+    r.errors = (int*)malloc(n * sizeof(int));
+    r.stop_at = n;
+    for (i = 0; i < n; i++)
+        r.errors[i] = -1;
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_KEY, lept_parse_ndjson_each(big, len, 4, ndjson_record, &r));
+    for (i = 0; i < n; i++)
+        if (r.errors[i] != LEPT_PARSE_OK || r.numbers[i] != (double)i)
+            break;
+    EXPECT_TRUE((i < n && r.errors[i] == LEPT_PARSE_MISS_KEY));
+    for (i++; i < n; i++)
+        if (r.errors[i] != LEPT_PARSE_OK)
+            break;
+    EXPECT_TRUE((i < n && r.errors[i] == LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET));
+    for (i++; i < n; i++)
+        if (r.errors[i] != LEPT_PARSE_OK || r.numbers[i] != (double)i)
+            break;
+    EXPECT_EQ_SIZE_T(n, i);
+
+    //回调返回0时中止解析
+    for (i = 0; i < n; i++)
+        r.errors[i] = -1;
+    r.stop_at = 5;
+    EXPECT_EQ_INT(LEPT_PARSE_TERMINATED, lept_parse_ndjson_each(big, len, 1, ndjson_record, &r));
+    for (i = 0; i < n && r.errors[i] != -1; i++)
+        ;
+    EXPECT_EQ_SIZE_T(6, i);
+
+    //映射文件逐条回调
+    fp = fopen(filename, "wb");
+    if (fp) {
+        fwrite(big, 1, len / 2, fp);
+        fclose(fp);
+        r.stop_at = n;
+        for (i = 0; i < n; i++)
+            r.errors[i] = -1;
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ndjson_file(filename, 2, ndjson_record, &r));
+        for (i = 0; i < n && r.errors[i] == LEPT_PARSE_OK; i++)
+            if (r.numbers[i] != (double)i)
+                break;
+        EXPECT_TRUE((i > 0 && i < n && r.errors[i] == -1));
+        remove(filename);
+    }
+    EXPECT_EQ_INT(LEPT_PARSE_FILE_ERROR, lept_parse_ndjson_file("leptjson_no_such_file.ndjson", 0, ndjson_record, &r));
+    free(r.numbers);
+    free(r.errors);
+    free(big);
 }
 
 int main(){
@@ -571,6 +2054,9 @@ int main(){
 #endif
 
     test_parse();
+    test_parse_file();
+    test_parse_ndjson();
+    test_parse_parallel();
     test_access();
     test_stringify();
     printf("pass: %d sum: %d (%3.2f%%)passed\n", test_pass, test_count, test_pass*100.0/test_count);
@@ -586,7 +2072,5 @@ int main(){
     // printf("num = %c\n", '\u4E25');
     // printf("num = %c\n", \xF0\x9D\x84\x9E);
 
-    test_parse_file();
-
     return main_ret;
 }
\ No newline at end of file